@@ -0,0 +1,285 @@
+// codecregistry.h
+#ifndef CODECREGISTRY_H
+#define CODECREGISTRY_H
+
+#include <QString>
+#include <QStringList>
+#include <cstddef>
+
+// Single source of truth for the codecs, containers and pixel formats the
+// converter offers, and which combinations of them are legal. Everything is
+// constexpr so a bad combination is rejected by a table lookup, long before
+// an ffmpeg process is spawned.
+namespace CodecRegistry {
+
+enum class Container : unsigned { MP4, AVI, MOV, MKV, WebM };
+enum class PixelFormat : unsigned { Yuv420p, Yuv420p10, Yuv422p10, Yuv444p10, Yuvj420p };
+
+// How an encoder's keyframe interval can be controlled
+enum class Gop : unsigned {
+    IntraOnly, // every frame is a keyframe
+    Keyframes, // -g / -keyint_min
+    ClosedGop, // -g / -keyint_min, and +cgop keeps references inside each GOP
+};
+
+struct ContainerInfo {
+    Container id;
+    const char *label;     // shown in the UI and stored in presets
+    const char *muxer;     // ffmpeg -f name
+    const char *extension; // output file extension
+    const char *audioEncoder; // for source audio the container cannot hold as is
+};
+
+struct PixelFormatInfo {
+    PixelFormat id;
+    const char *name; // ffmpeg -pix_fmt name
+    int bitDepth;
+};
+
+struct CodecInfo {
+    const char *label;   // shown in the UI and stored in presets
+    const char *encoder; // ffmpeg encoder; speed tiers may pick a sibling (prores_ks)
+    const char *stream;  // codec_name ffprobe reports for a stream of this codec
+    unsigned containers; // bitmask of Container
+    unsigned pixelFormats; // bitmask of PixelFormat
+    PixelFormat defaultPixelFormat;
+    Gop gop;
+};
+
+constexpr unsigned bit(Container container) { return 1u << static_cast<unsigned>(container); }
+constexpr unsigned bit(PixelFormat format) { return 1u << static_cast<unsigned>(format); }
+
+inline constexpr ContainerInfo containers[] = {
+    {Container::MP4,  "MP4",  "mp4",      "mp4",  "aac"},
+    {Container::AVI,  "AVI",  "avi",      "avi",  "aac"},
+    {Container::MOV,  "MOV",  "mov",      "mov",  "aac"},
+    {Container::MKV,  "MKV",  "matroska", "mkv",  "aac"},
+    {Container::WebM, "WebM", "webm",     "webm", "libopus"},
+};
+
+inline constexpr PixelFormatInfo pixelFormats[] = {
+    {PixelFormat::Yuv420p,   "yuv420p",     8},
+    {PixelFormat::Yuv420p10, "yuv420p10le", 10},
+    {PixelFormat::Yuv422p10, "yuv422p10le", 10},
+    {PixelFormat::Yuv444p10, "yuv444p10le", 10},
+    {PixelFormat::Yuvj420p,  "yuvj420p",    8}, // full-range, what JPEG files hold
+};
+
+inline constexpr CodecInfo codecs[] = {
+    {"H.264", "libx264", "h264",
+     bit(Container::MP4) | bit(Container::AVI) | bit(Container::MOV) | bit(Container::MKV),
+     bit(PixelFormat::Yuv420p) | bit(PixelFormat::Yuv420p10) | bit(PixelFormat::Yuv422p10) | bit(PixelFormat::Yuv444p10),
+     PixelFormat::Yuv420p, Gop::ClosedGop},
+    {"H.265", "libx265", "hevc",
+     bit(Container::MP4) | bit(Container::MOV) | bit(Container::MKV),
+     bit(PixelFormat::Yuv420p) | bit(PixelFormat::Yuv420p10) | bit(PixelFormat::Yuv422p10) | bit(PixelFormat::Yuv444p10),
+     PixelFormat::Yuv420p, Gop::ClosedGop},
+    {"VP9", "libvpx-vp9", "vp9",
+     bit(Container::MP4) | bit(Container::MKV) | bit(Container::WebM),
+     bit(PixelFormat::Yuv420p) | bit(PixelFormat::Yuv420p10) | bit(PixelFormat::Yuv444p10),
+     PixelFormat::Yuv420p, Gop::Keyframes},
+    {"ProRes", "prores", "prores",
+     bit(Container::MOV) | bit(Container::MKV),
+     bit(PixelFormat::Yuv422p10) | bit(PixelFormat::Yuv444p10),
+     PixelFormat::Yuv422p10, Gop::IntraOnly},
+    // Intra-only; a JPEG sequence can be muxed into it without decoding
+    {"MJPEG", "mjpeg", "mjpeg",
+     bit(Container::AVI) | bit(Container::MOV) | bit(Container::MKV),
+     bit(PixelFormat::Yuvj420p),
+     PixelFormat::Yuvj420p, Gop::IntraOnly},
+};
+
+// Audio a remux can stream-copy, by the codec_name ffprobe reports
+struct AudioCodecInfo {
+    const char *stream;
+    unsigned containers; // bitmask of Container
+};
+
+inline constexpr AudioCodecInfo audioCodecs[] = {
+    {"aac",       bit(Container::MP4) | bit(Container::AVI) | bit(Container::MOV) | bit(Container::MKV)},
+    {"mp3",       bit(Container::MP4) | bit(Container::AVI) | bit(Container::MOV) | bit(Container::MKV)},
+    {"ac3",       bit(Container::MP4) | bit(Container::AVI) | bit(Container::MOV) | bit(Container::MKV)},
+    {"eac3",      bit(Container::MP4) | bit(Container::MOV) | bit(Container::MKV)},
+    {"alac",      bit(Container::MP4) | bit(Container::MOV) | bit(Container::MKV)},
+    {"flac",      bit(Container::MP4) | bit(Container::MKV)},
+    {"opus",      bit(Container::MP4) | bit(Container::MKV) | bit(Container::WebM)},
+    {"vorbis",    bit(Container::MKV) | bit(Container::WebM)},
+    {"pcm_s16le", bit(Container::AVI) | bit(Container::MOV) | bit(Container::MKV)},
+    {"pcm_s24le", bit(Container::AVI) | bit(Container::MOV) | bit(Container::MKV)},
+};
+
+constexpr char toLower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+
+constexpr bool equalsIgnoreCase(const char *a, const char *b)
+{
+    for (; *a && *b; ++a, ++b) {
+        if (toLower(*a) != toLower(*b)) return false;
+    }
+    return *a == *b;
+}
+
+constexpr const CodecInfo *findCodec(const char *label)
+{
+    for (const CodecInfo &codec : codecs) {
+        if (equalsIgnoreCase(codec.label, label)) return &codec;
+    }
+    return nullptr;
+}
+
+// Looks a codec up by the name ffprobe reports for an existing stream
+constexpr const CodecInfo *findCodecByStream(const char *streamName)
+{
+    for (const CodecInfo &codec : codecs) {
+        if (equalsIgnoreCase(codec.stream, streamName)) return &codec;
+    }
+    return nullptr;
+}
+
+// Accepts the UI label, the extension or the muxer name ("MKV", "mkv", "matroska")
+constexpr const ContainerInfo *findContainer(const char *name)
+{
+    for (const ContainerInfo &container : containers) {
+        if (equalsIgnoreCase(container.label, name) || equalsIgnoreCase(container.extension, name)
+            || equalsIgnoreCase(container.muxer, name)) {
+            return &container;
+        }
+    }
+    return nullptr;
+}
+
+constexpr const AudioCodecInfo *findAudioCodecByStream(const char *streamName)
+{
+    for (const AudioCodecInfo &codec : audioCodecs) {
+        if (equalsIgnoreCase(codec.stream, streamName)) return &codec;
+    }
+    return nullptr;
+}
+
+constexpr const PixelFormatInfo *findPixelFormat(const char *name)
+{
+    for (const PixelFormatInfo &format : pixelFormats) {
+        if (equalsIgnoreCase(format.name, name)) return &format;
+    }
+    return nullptr;
+}
+
+constexpr bool isCompatible(const CodecInfo &codec, const ContainerInfo &container)
+{
+    return (codec.containers & bit(container.id)) != 0;
+}
+
+constexpr bool isCompatible(const CodecInfo &codec, const PixelFormatInfo &format)
+{
+    return (codec.pixelFormats & bit(format.id)) != 0;
+}
+
+// Unknown audio codecs are never copied; they are re-encoded with the container's audio encoder
+constexpr bool canCopyAudio(const char *streamName, const ContainerInfo &container)
+{
+    const AudioCodecInfo *codec = findAudioCodecByStream(streamName);
+    return codec && (codec->containers & bit(container.id)) != 0;
+}
+
+constexpr const PixelFormatInfo &pixelFormatInfo(PixelFormat id)
+{
+    return pixelFormats[static_cast<unsigned>(id)];
+}
+
+// Returns nullptr when the combination is legal, otherwise a reason; an empty
+// pixel format means "codec default"
+constexpr const char *validate(const char *codecLabel, const char *containerName, const char *pixelFormatName)
+{
+    const CodecInfo *codec = findCodec(codecLabel);
+    if (!codec) return "Unknown video codec.";
+    const ContainerInfo *container = findContainer(containerName);
+    if (!container) return "Unknown container format.";
+    if (!isCompatible(*codec, *container)) return "The selected codec cannot be stored in this container.";
+    if (pixelFormatName && *pixelFormatName) {
+        const PixelFormatInfo *format = findPixelFormat(pixelFormatName);
+        if (!format) return "Unknown pixel format.";
+        if (!isCompatible(*codec, *format)) return "The selected codec does not support this pixel format.";
+    }
+    return nullptr;
+}
+
+// Table sanity: tables are indexed by enum value and every codec must be usable somewhere
+constexpr bool tablesAreConsistent()
+{
+    for (std::size_t i = 0; i < sizeof(containers) / sizeof(containers[0]); ++i) {
+        if (static_cast<std::size_t>(containers[i].id) != i) return false;
+    }
+    for (std::size_t i = 0; i < sizeof(pixelFormats) / sizeof(pixelFormats[0]); ++i) {
+        if (static_cast<std::size_t>(pixelFormats[i].id) != i) return false;
+    }
+    for (const CodecInfo &codec : codecs) {
+        if (codec.containers == 0) return false;
+        if (!isCompatible(codec, pixelFormatInfo(codec.defaultPixelFormat))) return false;
+    }
+    return true;
+}
+
+static_assert(tablesAreConsistent(), "codec registry tables are inconsistent");
+static_assert(validate("ProRes", "WebM", "") != nullptr, "ProRes must not be muxed into WebM");
+static_assert(validate("VP9", "AVI", "") != nullptr, "VP9 must not be muxed into AVI");
+static_assert(validate("H.264", "mkv", "yuv420p") == nullptr, "H.264 in Matroska must be accepted");
+static_assert(validate("MJPEG", "MP4", "") != nullptr, "MJPEG must not be muxed into MP4");
+static_assert(findCodecByStream("hevc") == findCodec("H.265"), "ffprobe names must map to registry codecs");
+static_assert(findCodec("MJPEG")->gop == Gop::IntraOnly, "MJPEG has no GOP to segment on");
+static_assert(!canCopyAudio("aac", containers[static_cast<unsigned>(Container::WebM)]), "WebM must not take AAC audio");
+static_assert(canCopyAudio("opus", containers[static_cast<unsigned>(Container::WebM)]), "Opus in WebM must be copied");
+
+// Qt-facing helpers for the UI, presets and command builder
+
+inline const CodecInfo *codecForLabel(const QString &label)
+{
+    return findCodec(label.toLatin1().constData());
+}
+
+inline const CodecInfo *codecForStream(const QString &streamName)
+{
+    return findCodecByStream(streamName.toLatin1().constData());
+}
+
+inline const ContainerInfo *containerForName(const QString &name)
+{
+    return findContainer(name.toLatin1().constData());
+}
+
+inline bool canCopyAudio(const QString &streamName, const ContainerInfo &container)
+{
+    return canCopyAudio(streamName.toLatin1().constData(), container);
+}
+
+inline QString validate(const QString &codecLabel, const QString &containerName, const QString &pixelFormatName)
+{
+    const char *error = validate(codecLabel.toLatin1().constData(), containerName.toLatin1().constData(),
+                                 pixelFormatName.toLatin1().constData());
+    return error ? QString::fromLatin1(error) : QString();
+}
+
+inline QStringList codecLabels()
+{
+    QStringList labels;
+    for (const CodecInfo &codec : codecs) labels << codec.label;
+    return labels;
+}
+
+inline QStringList containerLabels()
+{
+    QStringList labels;
+    for (const ContainerInfo &container : containers) labels << container.label;
+    return labels;
+}
+
+inline QStringList pixelFormatNames(const CodecInfo &codec)
+{
+    QStringList names;
+    for (const PixelFormatInfo &format : pixelFormats) {
+        if (isCompatible(codec, format)) names << format.name;
+    }
+    return names;
+}
+
+} // namespace CodecRegistry
+
+#endif // CODECREGISTRY_H
@@ -0,0 +1,219 @@
+// concurrencycontroller.cpp
+#include "concurrencycontroller.h"
+#include <QFile>
+#include <QThread>
+#include <QStringList>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+const int SampleIntervalMs = 3000;
+const int SettleSamples = 2;     // samples after a change before its effect is judged
+const int CooldownSamples = 20;  // no new probes for a minute after a change was backed out
+const double IdleBelow = 0.75;   // busy CPU fraction under which another job is tried
+const double SaturatedAbove = 0.97;
+
+} // namespace
+
+ConcurrencyController::ConcurrencyController(QObject *parent)
+    : QObject(parent)
+    , timer(new QTimer(this))
+    , limit(1)
+    , maximum(qMax(2, QThread::idealThreadCount()))
+    , cores(qMax(1, QThread::idealThreadCount()))
+    , lastStep(0)
+    , fpsBeforeStep(0.0)
+    , settleSamples(0)
+    , cooldown(0)
+{
+    timer->setInterval(SampleIntervalMs);
+    connect(timer, &QTimer::timeout, this, &ConcurrencyController::sample);
+}
+
+bool ConcurrencyController::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return QFile::exists("/proc/stat");
+#else
+    return false;
+#endif
+}
+
+void ConcurrencyController::setSource(const std::function<Snapshot()> &snapshotSource)
+{
+    source = snapshotSource;
+}
+
+void ConcurrencyController::setEnabled(bool enabled)
+{
+    if (!enabled) {
+        timer->stop();
+        return;
+    }
+    if (!isSupported() || timer->isActive()) return;
+
+    readCpuTimes(lastCpu);
+    lastJobs.clear();
+    lastTicks.clear();
+    lastStep = 0;
+    cooldown = 0;
+    lastHold.clear();
+    clock.start();
+    timer->start();
+    emit logMessage(QString("Adaptive concurrency on: %1 job(s) with %2 thread(s) each, up to %3 jobs.")
+                    .arg(limit).arg(threadsPerJob()).arg(maximum));
+}
+
+bool ConcurrencyController::isEnabled() const
+{
+    return timer->isActive();
+}
+
+void ConcurrencyController::setMaximumJobs(int jobs)
+{
+    maximum = qMax(1, jobs);
+    if (limit > maximum) changeLimit(maximum, "maximum lowered");
+}
+
+int ConcurrencyController::jobLimit() const
+{
+    return limit;
+}
+
+int ConcurrencyController::threadsPerJob() const
+{
+    return qMax(1, cores / limit);
+}
+
+bool ConcurrencyController::readCpuTimes(CpuTimes &times)
+{
+    // First line: "cpu  user nice system idle iowait irq softirq steal guest guest_nice"
+    QFile file("/proc/stat");
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QList<QByteArray> fields = file.readLine().simplified().split(' ');
+    if (fields.size() < 9 || fields.first() != "cpu") return false;
+
+    quint64 total = 0;
+    for (int i = 1; i <= 8; ++i) total += fields.at(i).toULongLong(); // guest time is already in user
+    quint64 idle = fields.at(4).toULongLong();
+    times.iowait = fields.at(5).toULongLong();
+    times.total = total;
+    times.busy = total - idle - times.iowait;
+    return true;
+}
+
+quint64 ConcurrencyController::readProcessTicks(qint64 pid)
+{
+    // utime and stime are fields 14 and 15; the command name before them may contain spaces
+    QFile file(QString("/proc/%1/stat").arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+    QByteArray line = file.readAll();
+    int end = line.lastIndexOf(')');
+    if (end < 0) return 0;
+    QList<QByteArray> fields = line.mid(end + 2).split(' ');
+    if (fields.size() < 13) return 0;
+    return fields.at(11).toULongLong() + fields.at(12).toULongLong();
+}
+
+void ConcurrencyController::sample()
+{
+    if (!source) return;
+
+    CpuTimes cpu;
+    if (!readCpuTimes(cpu)) return;
+    double seconds = clock.restart() / 1000.0;
+    quint64 total = cpu.total - lastCpu.total;
+    if (seconds <= 0 || total == 0) return;
+    double busy = double(cpu.busy - lastCpu.busy) / total;
+    double iowait = double(cpu.iowait - lastCpu.iowait) / total;
+    lastCpu = cpu;
+
+    Snapshot snapshot = source();
+    double fps = 0.0;
+    QStringList perJob;
+#ifdef Q_OS_UNIX
+    static const double ticksPerSecond = double(sysconf(_SC_CLK_TCK));
+#else
+    static const double ticksPerSecond = 100.0;
+#endif
+    QHash<qint64, quint64> ticks;
+    for (auto it = snapshot.running.cbegin(); it != snapshot.running.cend(); ++it) {
+        const RunningJob &job = it.value();
+        if (lastJobs.contains(it.key())) {
+            fps += qMax(0, job.frames - lastJobs.value(it.key()).frames) / seconds;
+        }
+        if (job.pid <= 0) continue;
+        quint64 used = readProcessTicks(job.pid);
+        ticks.insert(job.pid, used);
+        if (lastTicks.contains(job.pid)) {
+            perJob << QString("#%1 %2 cores").arg(it.key())
+                      .arg((used - lastTicks.value(job.pid)) / ticksPerSecond / seconds, 0, 'f', 1);
+        }
+    }
+    lastJobs = snapshot.running;
+    lastTicks = ticks;
+
+    QString metrics = QString("cpu %1%, iowait %2%, %3 fps from %4 job(s)")
+                      .arg(qRound(busy * 100)).arg(qRound(iowait * 100)).arg(fps, 0, 'f', 1)
+                      .arg(snapshot.running.size());
+    if (!perJob.isEmpty()) metrics += " [" + perJob.join(", ") + "]";
+
+    // Judge the last change once it has settled
+    if (lastStep != 0) {
+        if (--settleSamples > 0) return;
+        int step = lastStep;
+        lastStep = 0;
+        bool worse = step > 0 ? fps < fpsBeforeStep * 1.05 : fps < fpsBeforeStep * 0.95;
+        if (worse) {
+            cooldown = CooldownSamples;
+            changeLimit(limit - step, QString("backing out, %1 fps before the change; %2")
+                                      .arg(fpsBeforeStep, 0, 'f', 1).arg(metrics));
+        } else {
+            emit logMessage(QString("Concurrency %1 kept: %2").arg(limit).arg(metrics));
+        }
+        return;
+    }
+
+    if (cooldown > 0) cooldown--;
+    bool full = snapshot.running.size() >= limit;
+    QString hold;
+    if (snapshot.waiting == 0 || !full) {
+        hold = "no job waiting for a slot";
+    } else if (cooldown > 0) {
+        hold = "cooling down after a backed-out change";
+    } else if (busy < IdleBelow && limit < maximum) {
+        fpsBeforeStep = fps;
+        lastStep = 1;
+        settleSamples = SettleSamples;
+        changeLimit(limit + 1, QString("%1; %2").arg(iowait > 0.2 ? "jobs are waiting on I/O" : "cores are idle", metrics));
+        return;
+    } else if (busy > SaturatedAbove && iowait < 0.05 && limit > 1) {
+        fpsBeforeStep = fps;
+        lastStep = -1;
+        settleSamples = SettleSamples;
+        changeLimit(limit - 1, QString("CPU saturated; %1").arg(metrics));
+        return;
+    } else {
+        hold = limit >= maximum ? "at the maximum" : "CPU well used";
+    }
+
+    if (hold != lastHold) {
+        lastHold = hold;
+        emit logMessage(QString("Concurrency held at %1, %2: %3").arg(limit).arg(hold, metrics));
+    }
+}
+
+void ConcurrencyController::changeLimit(int jobs, const QString &reason)
+{
+    jobs = qBound(1, jobs, maximum);
+    if (jobs == limit) return;
+    int previous = limit;
+    limit = jobs;
+    lastHold.clear();
+    emit logMessage(QString("Concurrency %1 -> %2 job(s), %3 thread(s) each: %4")
+                    .arg(previous).arg(limit).arg(threadsPerJob()).arg(reason));
+    emit limitChanged(limit, threadsPerJob());
+}
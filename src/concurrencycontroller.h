@@ -0,0 +1,82 @@
+// concurrencycontroller.h
+#ifndef CONCURRENCYCONTROLLER_H
+#define CONCURRENCYCONTROLLER_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <functional>
+
+// Picks how many jobs the queue runs at once, and how many ffmpeg threads each
+// gets, from what the machine is doing. Every few seconds it samples system
+// CPU and iowait from /proc/stat, each running ffmpeg's CPU time from
+// /proc/<pid>/stat and the frames the jobs reported. It adds a job while
+// cores sit idle or wait on I/O, and backs a step out when the change did not
+// raise total frames per second. Linux only; elsewhere the queue keeps its
+// fixed limit.
+class ConcurrencyController : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct RunningJob {
+        qint64 pid = 0;  // ffmpeg process, 0 while not started
+        int frames = 0;  // frames finished so far
+    };
+    struct Snapshot {
+        QHash<int, RunningJob> running;
+        int waiting = 0; // jobs that could start if there were room
+    };
+
+    explicit ConcurrencyController(QObject *parent = nullptr);
+
+    static bool isSupported();
+
+    void setSource(const std::function<Snapshot()> &source);
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    void setMaximumJobs(int jobs);
+
+    int jobLimit() const;
+    int threadsPerJob() const;
+
+signals:
+    void limitChanged(int jobs, int threadsPerJob);
+    void logMessage(const QString &message);
+
+private slots:
+    void sample();
+
+private:
+    struct CpuTimes {
+        quint64 busy = 0;
+        quint64 iowait = 0;
+        quint64 total = 0;
+    };
+
+    static bool readCpuTimes(CpuTimes &times);
+    static quint64 readProcessTicks(qint64 pid);
+    void changeLimit(int jobs, const QString &reason);
+
+    QTimer *timer;
+    std::function<Snapshot()> source;
+    int limit;
+    int maximum;
+    int cores;
+
+    // Previous sample
+    CpuTimes lastCpu;
+    QHash<int, RunningJob> lastJobs;
+    QHash<qint64, quint64> lastTicks; // per ffmpeg pid
+    QElapsedTimer clock;
+
+    // The change being evaluated: throughput before it, and samples left until it is judged
+    int lastStep;          // +1, -1, or 0 when nothing is being evaluated
+    double fpsBeforeStep;
+    int settleSamples;
+    int cooldown;          // samples left before another change is tried
+    QString lastHold;      // holds are only logged when the reason changes
+};
+
+#endif // CONCURRENCYCONTROLLER_H
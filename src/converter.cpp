@@ -1,17 +1,67 @@
 // converter.cpp
 #include "converter.h"
+#include "encodertuner.h"
+#include "codecregistry.h"
+#include "imageencodepool.h"
+#include "videoprobe.h"
+#include "frameprefetcher.h"
+#include "tracerecorder.h"
+#include "framearchive.h"
+#include "framenaming.h"
+#include "sequencetranscoder.h"
+#include "dedupmanifest.h"
 #include <QApplication>
 #include <QStandardPaths>
 #include <QRegularExpression>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QFile>
+#include <QSaveFile>
+#include <QDirIterator>
+#include <QImageReader>
 #include <QDebug>
+#include <QtConcurrent/QtConcurrentRun>
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#endif
+#include <algorithm>
+#include <cstring>
 
-Converter::Converter(QObject *parent)
+Converter::Converter(QObject *parent, bool lookUpFFmpeg)
     : QObject(parent)
     , ffmpegProcess(nullptr)
     , isProcessing(false)
     , totalFrames(0)
+    , framesCompleted(0)
+    , currentStepFrames(0)
+    , finalizeWatcher(nullptr)
+    , segmentWatcher(nullptr)
+    , segmentsReported(0)
+    , followTimer(nullptr)
+    , tuner(nullptr)
+    , transcoder(nullptr)
+    , prefetcher(nullptr)
+    , prefetchBase(-1)
+    , encodePool(nullptr)
+    , archiveWriter(nullptr)
+    , probeWatcher(nullptr)
+    , paused(false)
+    , processStopped(false)
+    , pausedMs(0)
+    , trace(nullptr)
+    , traceTrack(0)
 {
-    ffmpegPath = findFFmpegPath();
+    if (lookUpFFmpeg) {
+        ffmpegPath = findFFmpegPath();
+    }
+
+    // Every way a conversion ends goes through finished(), so the overall span is closed here
+    connect(this, &Converter::finished, this, [this](bool success, const QString &message) {
+        traceSpan("convert", marks.conversion, {{"success", success}, {"message", message}});
+        marks = TraceMarks();
+    });
 }
 
 Converter::~Converter()
@@ -27,7 +77,7 @@ bool Converter::isFFmpegAvailable()
     return !ffmpegPath.isEmpty();
 }
 
-QString Converter::findFFmpegPath() const
+QString Converter::findFFmpegPath()
 {
     // Check common installation paths
     QStringList possiblePaths = {
@@ -46,6 +96,22 @@ QString Converter::findFFmpegPath() const
     return QString();
 }
 
+void Converter::setTrace(TraceRecorder *recorder, int track)
+{
+    trace = recorder;
+    traceTrack = track;
+}
+
+void Converter::traceSpan(const QString &name, qint64 startUs, const QJsonObject &args)
+{
+    if (trace) trace->span(traceTrack, name, "convert", startUs, args);
+}
+
+void Converter::setFFmpegPath(const QString &path)
+{
+    ffmpegPath = path;
+}
+
 void Converter::convertSequenceToVideo(const ConversionSettings &settings)
 {
     if (isProcessing) {
@@ -58,30 +124,146 @@ void Converter::convertSequenceToVideo(const ConversionSettings &settings)
         return;
     }
     
+    paused = false;
+    pausedMs = 0;
+    if (trace && marks.conversion < 0) marks.conversion = trace->now(); // auto-tuning re-enters
+
+    // Reject illegal codec/container/pixel format combinations before anything is spawned
+    QString invalid = validateSettings(settings);
+    if (!invalid.isEmpty()) {
+        emit finished(false, invalid);
+        return;
+    }
+    
+    // Intra-only output has nothing a segment boundary saves; encode it whole
+    const CodecRegistry::CodecInfo *codec = CodecRegistry::codecForLabel(settings.videoCodec);
+    if (settings.incremental && codec && codec->gop == CodecRegistry::Gop::IntraOnly) {
+        emit logMessage(QString("%1 is intra-only, encoding without segments.").arg(settings.videoCodec));
+        ConversionSettings whole = settings;
+        whole.incremental = false;
+        convertSequenceToVideo(whole);
+        return;
+    }
+    
     currentSettings = settings;
+    pendingSteps.clear();
+    finalizeStep = nullptr;
+    backgroundFinalizeStep = nullptr;
+    dedup = DedupState();
+    
+    if (settings.writeChecksums && settings.streamingMode != "None") {
+        emit finished(false, "Checksums are not available for streaming output.");
+        return;
+    }
+    
+    if (settings.writeChecksums) {
+        addChecksumFinalizeStep(settings.outputPath, settings.outputPath + ".checksums.json", nullptr);
+    }
+    
+    if (settings.followSequence) {
+        if (settings.incremental) {
+            emit finished(false, "Incremental re-encode cannot be combined with follow mode.");
+            return;
+        }
+        emit logMessage(QString("Following %1, waiting for frames...").arg(settings.inputPath));
+        startFollowing();
+        return;
+    }
     
-    // Find image files in the directory
-    QStringList imageFiles = findImageFiles(settings.inputPath);
+    // Find image files in the directory, unless the caller already scanned it
+    QStringList imageFiles = settings.imageFiles.isEmpty() ? findImageFiles(settings.inputPath) : settings.imageFiles;
     if (imageFiles.isEmpty()) {
         emit finished(false, "No image files found in the selected directory.");
         return;
     }
     
     totalFrames = imageFiles.size();
+    framesCompleted = 0;
+    
+    QString codecName = getVideoCodecName(settings.videoCodec);
+    if (settings.autoTune && (codecName == "libx264" || codecName == "libx265")) {
+        isProcessing = true;
+        tuner = new EncoderTuner(this, ffmpegPath, this);
+        if (trace) marks.tuning = trace->now();
+        connect(tuner, &EncoderTuner::logMessage, this, &Converter::logMessage);
+        connect(tuner, &EncoderTuner::finished, this, [this](bool success, const QString &preset, int quality) {
+            tuner->deleteLater();
+            tuner = nullptr;
+            traceSpan("auto-tune", marks.tuning, {{"success", success}, {"preset", preset}, {"crf", quality}});
+            isProcessing = false;
+            if (!success) {
+                emit finished(false, "Auto-tuning failed or was cancelled.");
+                return;
+            }
+            // Record the choice on the job, then run it as an ordinary conversion
+            ConversionSettings tuned = currentSettings;
+            tuned.encoderPreset = preset;
+            tuned.quality = quality;
+            tuned.autoTune = false;
+            emit encoderTuned(preset, quality);
+            convertSequenceToVideo(tuned);
+        });
+        tuner->tune(settings, imageFiles);
+        return;
+    } else if (settings.autoTune) {
+        emit logMessage(QString("Auto-tune only applies to H.264/H.265, keeping settings for %1.").arg(settings.videoCodec));
+    }
     
+    if (settings.incremental && settings.streamingMode != "None") {
+        emit finished(false, "Incremental re-encode cannot be combined with streaming output.");
+        return;
+    }
+    
+    startPrefetching(imageFiles);
+    
+    if (settings.incremental) {
+        if (settings.expandDuplicates && DedupManifest::exists(settings.inputPath)) {
+            emit logMessage("Incremental re-encodes use the stored frames as they are; duplicates are not expanded.");
+        }
+        QString error;
+        if (!prepareIncrementalEncode(imageFiles, error)) {
+            stopPrefetching();
+            emit finished(false, error);
+            return;
+        }
+        if (pendingSteps.isEmpty()) {
+            stopPrefetching();
+            emit progressChanged(100);
+            emit finished(true, "Output is already up to date, nothing to re-encode.");
+            return;
+        }
+        emit logMessage("Starting incremental conversion...");
+        isProcessing = true;
+        startNextStep();
+        return;
+    }
+    
+    bool expand = expandsDuplicates(settings);
+    if (expand) {
+        QString error;
+        int originalFrames = 0;
+        if (!DedupManifest::writeConcatList(settings.inputPath, settings.frameRate, originalFrames, error)) {
+            stopPrefetching();
+            emit finished(false, error);
+            return;
+        }
+        totalFrames = originalFrames;
+        emit logMessage(QString("Expanding %1 stored frames back to the %2 frames of the original.")
+                        .arg(imageFiles.size()).arg(originalFrames));
+    }
     QStringList args = buildFFmpegArguments(settings, true);
 
+    if (!settings.followSequence && !expand && canPassThroughJpeg(settings, imageFiles)) {
+        emit logMessage("JPEG frames already match the output size; copying them into the video without re-encoding.");
+    }
     emit logMessage("Starting conversion...");
-    emit logMessage("Command: " + ffmpegPath + " " + args.join(" "));
-    
-    ffmpegProcess = new QProcess(this);
-    connect(ffmpegProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, &Converter::onProcessFinished);
-    connect(ffmpegProcess, &QProcess::errorOccurred, this, &Converter::onProcessError);
-    connect(ffmpegProcess, &QProcess::readyReadStandardError, this, &Converter::onProcessOutput);
-    
-    isProcessing = true;
-    ffmpegProcess->start(ffmpegPath, args);
+    marks.step = "encode";
+    if (settings.streamingMode == "HLS" || settings.streamingMode == "DASH") {
+        watchStreamingSegments();
+    }
+    prefetchBase = expand ? -1 : 0; // output frame numbers no longer match the files
+    if (prefetcher) prefetcher->advanceTo(0);
+    startProcess(args);
 }
 
 void Converter::convertVideoToSequence(const ConversionSettings &settings)
@@ -96,7 +278,17 @@ void Converter::convertVideoToSequence(const ConversionSettings &settings)
         return;
     }
     
+    paused = false;
+    pausedMs = 0;
+    if (trace && marks.conversion < 0) marks.conversion = trace->now(); // auto-tuning re-enters
+
     currentSettings = settings;
+    pendingSteps.clear();
+    finalizeStep = nullptr;
+    backgroundFinalizeStep = nullptr;
+    totalFrames = 0;
+    framesCompleted = 0;
+    dedup = DedupState();
 
     // Ensure output directory exists
     QDir outDir(settings.outputPath);
@@ -107,9 +299,189 @@ void Converter::convertVideoToSequence(const ConversionSettings &settings)
         }
     }
     
-    QStringList args = buildFFmpegArguments(settings, false);
+    QString templateError = FrameNaming::validateTemplate(settings.nameTemplate);
+    if (!templateError.isEmpty()) {
+        emit finished(false, templateError);
+        return;
+    }
+
+    if (!settings.samplingMode.isEmpty() && settings.samplingMode != "All") {
+        if (settings.frameArchive) {
+            emit finished(false, "Frame archives take whole extractions or ranges; sampled frames are written as files.");
+            return;
+        }
+        if (settings.parallelImageEncode || settings.writeChecksums || settings.dedupFrames) {
+            emit logMessage("Parallel image encoding, checksums and duplicate elimination are not used when sampling frames.");
+        }
+        probeInput(settings.inputPath, settings.samplingMode == "Keyframes", [this, settings](const ProbeResult &probe) {
+            QString error;
+            if (!prepareSampledExtraction(settings, probe, error)) {
+                isProcessing = false;
+                emit finished(false, error);
+                return;
+            }
+            startNextStep();
+        });
+        return;
+    }
+
+    // Archives are written by the encode pool, which hands over each frame's bytes
+    if (settings.frameArchive && !ImageEncodePool::supportsFormat(settings.imageFormat)) {
+        emit finished(false, QString("Frame archives cannot hold %1 frames; use PNG, JPEG, TIFF or BMP.").arg(settings.imageFormat));
+        return;
+    }
+    if (settings.parallelImageEncode || settings.frameArchive) {
+        if (ImageEncodePool::supportsFormat(settings.imageFormat)) {
+            probeInput(settings.inputPath, false, [this, settings](const ProbeResult &probe) {
+                QString error;
+                if (!startRawExtraction(settings, probe, error)) {
+                    isProcessing = false;
+                    emit finished(false, error);
+                }
+            });
+            return;
+        }
+        emit logMessage(QString("Parallel image encoding does not support %1; using the FFmpeg encoder.").arg(settings.imageFormat));
+    }
+
+    probeInput(settings.inputPath, false, [this, settings](const ProbeResult &probe) {
+        startVideoExtraction(settings, probe);
+    });
+}
+
+void Converter::startVideoExtraction(const ConversionSettings &settings, const ProbeResult &probe)
+{
+    // The padding has to cover the whole extraction; if the probe fails only the width falls back
+    const VideoInfo &info = probe.info;
+    if (probe.ok) {
+        totalFrames = settings.extractAllFrames ? info.frameCount : settings.endFrame - settings.startFrame + 1;
+    } else if (settings.dedupFrames) {
+        // Without the frame rate the kept frames cannot be placed in the source
+        isProcessing = false;
+        emit finished(false, probe.error);
+        return;
+    }
+    QDir outDir(settings.outputPath);
+    FrameNaming naming(settings, totalFrames);
+    ConversionSettings named = settings;
+    named.framePadding = naming.padding();
+    QStringList args = buildFFmpegArguments(named, false);
+    
+    if (settings.writeChecksums) {
+        addChecksumFinalizeStep(outDir.absoluteFilePath("checksums"), outDir.absoluteFilePath("checksums.json"),
+                                [naming](int number) { return naming.relativePath(number); });
+    }
+    // ffmpeg writes one flat directory; the frames are moved into their shards afterwards
+    addShardFinalizeStep(naming);
+    if (settings.dedupFrames) {
+        beginDedup(settings, info, naming);
+        auto previous = finalizeStep;
+        finalizeStep = [this, previous](QString &error) {
+            if (previous && !previous(error)) return false;
+            return finishDedup(error);
+        };
+    }
     
     emit logMessage("Starting video extraction...");
+    marks.step = "extract";
+    startProcess(args);
+}
+
+void Converter::convertVideoToVideo(const ConversionSettings &settings)
+{
+    if (isProcessing) {
+        emit finished(false, "Another conversion is already in progress.");
+        return;
+    }
+    
+    if (ffmpegPath.isEmpty()) {
+        emit finished(false, "FFmpeg not found. Please install FFmpeg and restart the application.");
+        return;
+    }
+    
+    paused = false;
+    pausedMs = 0;
+    if (trace && marks.conversion < 0) marks.conversion = trace->now(); // auto-tuning re-enters
+
+    currentSettings = settings;
+    pendingSteps.clear();
+    finalizeStep = nullptr;
+    backgroundFinalizeStep = nullptr;
+    framesCompleted = 0;
+    dedup = DedupState();
+
+    probeInput(settings.inputPath, false, [this, settings](const ProbeResult &probe) {
+        if (!probe.ok) {
+            isProcessing = false;
+            emit finished(false, probe.error);
+            return;
+        }
+        const VideoInfo &info = probe.info;
+        totalFrames = info.frameCount;
+
+        if (canStreamCopy(info.codec, settings.videoFormat)) {
+            emit logMessage(QString("%1 can be stored in %2 as is; copying streams without re-encoding.")
+                            .arg(info.codec, settings.videoFormat.toUpper()));
+        } else {
+            emit logMessage(QString("%1 cannot be stored in %2; re-encoding with %3.")
+                            .arg(info.codec, settings.videoFormat.toUpper(), settings.videoCodec));
+        }
+        const CodecRegistry::ContainerInfo *container = CodecRegistry::containerForName(settings.videoFormat);
+        if (!info.audioCodec.isEmpty() && container && !CodecRegistry::canCopyAudio(info.audioCodec, *container)) {
+            emit logMessage(QString("%1 audio cannot be stored in %2; re-encoding it with %3.")
+                            .arg(info.audioCodec, settings.videoFormat.toUpper(), container->audioEncoder));
+        }
+        marks.step = canStreamCopy(info.codec, settings.videoFormat) ? "remux" : "re-encode";
+        startProcess(buildRemuxArguments(settings, info));
+    });
+}
+
+void Converter::convertSequenceToSequence(const ConversionSettings &settings)
+{
+    if (isProcessing) {
+        emit finished(false, "Another conversion is already in progress.");
+        return;
+    }
+    
+    if (ffmpegPath.isEmpty()) {
+        emit finished(false, "FFmpeg not found. Please install FFmpeg and restart the application.");
+        return;
+    }
+    
+    paused = false;
+    pausedMs = 0;
+    if (trace && marks.conversion < 0) marks.conversion = trace->now();
+
+    currentSettings = settings;
+    pendingSteps.clear();
+    finalizeStep = nullptr;
+    backgroundFinalizeStep = nullptr;
+
+    QStringList imageFiles = settings.imageFiles.isEmpty() ? findImageFiles(settings.inputPath) : settings.imageFiles;
+    if (imageFiles.isEmpty()) {
+        emit finished(false, "No image files found in the selected directory.");
+        return;
+    }
+
+    // Many short ffmpeg runs instead of one long one; the transcoder reports like a single step
+    isProcessing = true;
+    qint64 transcodeStart = trace ? trace->now() : -1;
+    transcoder = new SequenceTranscoder(ffmpegPath, this);
+    connect(transcoder, &SequenceTranscoder::logMessage, this, &Converter::logMessage);
+    connect(transcoder, &SequenceTranscoder::progressChanged, this, &Converter::progressChanged);
+    connect(transcoder, &SequenceTranscoder::frameProgress, this, &Converter::frameProgress);
+    connect(transcoder, &SequenceTranscoder::finished, this, [this, transcodeStart](bool success, const QString &message) {
+        transcoder->deleteLater();
+        transcoder = nullptr;
+        traceSpan("transcode", transcodeStart);
+        isProcessing = false;
+        emit finished(success, message);
+    });
+    transcoder->start(settings, imageFiles);
+}
+
+void Converter::startProcess(const QStringList &args)
+{
     emit logMessage("Command: " + ffmpegPath + " " + args.join(" "));
     
     ffmpegProcess = new QProcess(this);
@@ -117,193 +489,1585 @@ void Converter::convertVideoToSequence(const ConversionSettings &settings)
             this, &Converter::onProcessFinished);
     connect(ffmpegProcess, &QProcess::errorOccurred, this, &Converter::onProcessError);
     connect(ffmpegProcess, &QProcess::readyReadStandardError, this, &Converter::onProcessOutput);
+    connect(ffmpegProcess, &QProcess::started, this, [this]() {
+        traceSpan("spawn", marks.spawn);
+        if (trace) marks.started = trace->now();
+    });
     
     isProcessing = true;
+    processStopped = false;
+    if (trace) {
+        marks.spawn = trace->now();
+        marks.started = -1;
+        marks.firstFrame = -1;
+    }
     ffmpegProcess->start(ffmpegPath, args);
 }
 
+void Converter::startNextStep()
+{
+    ConversionStep step = pendingSteps.takeFirst();
+    currentStepFrames = step.frames;
+    prefetchBase = step.firstFrame;
+    marks.step = step.description;
+    if (prefetcher && prefetchBase >= 0) prefetcher->advanceTo(prefetchBase);
+    emit logMessage(step.description);
+    startProcess(step.arguments);
+}
+
+void Converter::startPrefetching(const QStringList &imageFiles)
+{
+    stopPrefetching();
+    if (currentSettings.prefetchDepth <= 0) return;
+    prefetcher = new FramePrefetcher(imageFiles, currentSettings.prefetchDepth, this);
+    emit logMessage(QString("Reading %1 frames ahead with %2.").arg(currentSettings.prefetchDepth).arg(FramePrefetcher::method()));
+}
+
+void Converter::stopPrefetching()
+{
+    delete prefetcher; // drops queued hints, waits for the ones in flight
+    prefetcher = nullptr;
+    prefetchBase = -1;
+}
+
 QStringList Converter::buildFFmpegArguments(const ConversionSettings &settings, bool isSequenceToVideo)
 {
     QStringList args;
 
     if (isSequenceToVideo) {
         // Image sequence to video
-        QStringList imageFiles = findImageFiles(settings.inputPath);
-        if (!imageFiles.isEmpty()) {
-            QFileInfo fileInfo(imageFiles.first());
-            QString baseName = fileInfo.baseName();
-            QString extension = fileInfo.suffix();
-
-            QRegularExpression numberPattern("(\\d+)$");
-            QRegularExpressionMatch match = numberPattern.match(baseName);
-
-            QString inputPattern;
-            if (match.hasMatch()) {
-                QString numberPart = match.captured(1);
-                QString nameWithoutNumber = baseName.left(baseName.length() - numberPart.length());
-                inputPattern = QDir(settings.inputPath).absoluteFilePath(
-                    QString("%1%2.%3").arg(nameWithoutNumber).arg("%04d").arg(extension));
-            } else {
-                inputPattern = QDir(settings.inputPath).absoluteFilePath(QString("*.%1").arg(extension));
-            }
-
-            args << "-framerate" << QString::number(settings.frameRate);
-            args << "-i" << inputPattern;
+        QStringList imageFiles = settings.imageFiles.isEmpty() ? findImageFiles(settings.inputPath) : settings.imageFiles;
+        bool expand = expandsDuplicates(settings);
+        if (settings.followSequence) {
+            QString extension = imageFiles.isEmpty() ? QString("png") : QFileInfo(imageFiles.first()).suffix();
+            args << buildPipeInputArguments(settings, extension);
+        } else if (expand) {
+            // Each stored frame is shown for its whole run; constant-rate output turns the runs back into frames
+            args << "-f" << "concat" << "-safe" << "0" << "-i" << DedupManifest::concatListPath(settings.inputPath);
+            args << "-fps_mode" << "cfr" << "-r" << QString::number(settings.frameRate);
+        } else if (!imageFiles.isEmpty()) {
+            args << buildSequenceInputArguments(imageFiles, 0, imageFiles.size(), settings.frameRate);
         }
 
-        QString codecName = getVideoCodecName(settings.videoCodec);
-        args << "-c:v" << codecName;
-
-        if (codecName.contains("libx264") || codecName.contains("libx265")) {
-            args << "-crf" << QString::number(settings.quality);
+        if (!settings.followSequence && !expand && canPassThroughJpeg(settings, imageFiles)) {
+            args << "-c:v" << "copy"; // image2 already yields MJPEG packets
+        } else {
+            args << buildVideoEncodeArguments(settings);
         }
-
-        if (settings.maintainAspectRatio) {
-            args << "-vf" << QString("scale=%1:%2:force_original_aspect_ratio=decrease,pad=%1:%2:(ow-iw)/2:(oh-ih)/2")
-                             .arg(settings.width).arg(settings.height);
+        QList<DedupManifest::Entry> entries;
+        int originalFrames = 0;
+        QString manifestError;
+        if (expand && DedupManifest::read(settings.inputPath, entries, originalFrames, manifestError)) {
+            args << "-frames:v" << QString::number(originalFrames); // the repeated last entry adds no frame
+        }
+        if (settings.streamingMode != "None") {
+            args << buildStreamingArguments(settings);
+            args << "-y" << settings.outputPath;
+        } else if (settings.writeChecksums) {
+            args << buildChecksumOutputArguments(muxerName(settings.videoFormat), settings.outputPath, settings.outputPath);
         } else {
-            args << "-s" << QString("%1x%2").arg(settings.width).arg(settings.height);
+            args << "-f" << muxerName(settings.videoFormat);
+            args << "-y";
+            args << settings.outputPath;
         }
 
-        args << "-f" << settings.videoFormat.toLower();
-        args << "-y";
-        args << settings.outputPath;
-
     } else {
         // Video to sequence
+        if (settings.threads > 0) {
+            args << "-threads" << QString::number(settings.threads); // decoder threads
+        }
         args << "-i" << settings.inputPath;
 
-        if (!settings.extractAllFrames) {
-            args << "-ss" << QString::number(settings.startFrame);
-            args << "-frames:v" << QString::number(settings.endFrame - settings.startFrame + 1);
+        if (settings.dedupFrames) {
+            args << dedupFilterArguments(settings);
+        } else if (!settings.extractAllFrames) {
+            args << "-vf" << rangeFilter(settings);
         }
 
-        QString outputPattern = QDir(settings.outputPath).absoluteFilePath(
-            QString("frame_%04d.%1").arg(settings.imageFormat.toLower()));
-        args << outputPattern;
+        QString outputPattern = FrameNaming(settings, 0).ffmpegPattern();
+        if (settings.writeChecksums) {
+            args << buildChecksumOutputArguments("image2", outputPattern,
+                                                 QDir(settings.outputPath).absoluteFilePath("checksums"));
+        } else {
+            args << outputPattern;
+        }
     }
 
     return args;
 }
 
-
-QString Converter::getVideoCodecName(const QString &codec)
+QStringList Converter::buildChecksumOutputArguments(const QString &format, const QString &output, const QString &sidecarBase) const
 {
-    if (codec == "H.264") return "libx264";
-    if (codec == "H.265") return "libx265";
-    if (codec == "VP9") return "libvpx-vp9";
-    if (codec == "ProRes") return "prores";
-    return "libx264"; // Default
+    // tee slave specs use '|' as separator and '[' ']' for options, so escape them in paths
+    auto teeEscape = [](QString path) {
+        path.replace("\\", "\\\\");
+        for (const char *special : {"|", "[", "]"}) {
+            path.replace(special, QString("\\") + special);
+        }
+        return path;
+    };
+
+    // The encoded packets fan out to the real output and both hashers, so nothing is read back
+    QStringList args;
+    args << "-map" << "0:v";
+    const CodecRegistry::ContainerInfo *container = CodecRegistry::containerForName(format);
+    if (container) {
+        // Any audio goes to the video file as it would without checksums; the hashes cover the frames only
+        args << "-map" << "0:a?" << "-c:a" << container->audioEncoder;
+        // The tee muxer cannot ask the encoder for extradata, which MP4/MOV/Matroska keep in the header
+        if (container->id != CodecRegistry::Container::AVI) args << "-flags" << "+global_header";
+    }
+    args << "-f" << "tee";
+    args << "-y";
+    args << QString("[f=%1]%2|[f=framemd5:select=v]%3|[f=hash:hash=sha256:select=v]%4")
+            .arg(format, teeEscape(output),
+                 teeEscape(sidecarBase + ".framemd5"),
+                 teeEscape(sidecarBase + ".sha256"));
+    return args;
 }
 
-QString Converter::getVideoFormatExtension(const QString &format)
+void Converter::addChecksumFinalizeStep(const QString &sidecarBase, const QString &manifestPath,
+                                        const std::function<QString(int)> &frameName)
 {
-    QString lowerFormat = format.toLower();
-    if (lowerFormat == "mp4") return "mp4";
-    if (lowerFormat == "avi") return "avi";
-    if (lowerFormat == "mov") return "mov";
-    if (lowerFormat == "mkv") return "mkv";
-    if (lowerFormat == "webm") return "webm";
-    return "mp4"; // Default
+    auto previous = finalizeStep;
+    QString outputPath = currentSettings.outputPath;
+
+    finalizeStep = [previous, sidecarBase, manifestPath, frameName, outputPath](QString &error) {
+        if (previous && !previous(error)) return false;
+
+        QFile frameHashes(sidecarBase + ".framemd5");
+        QFile streamHash(sidecarBase + ".sha256");
+        if (!frameHashes.open(QIODevice::ReadOnly) || !streamHash.open(QIODevice::ReadOnly)) {
+            error = QString("Checksum output missing next to %1").arg(sidecarBase);
+            return false;
+        }
+
+        // framemd5 lines: stream, dts, pts, duration, size, md5
+        QJsonArray frames;
+        int index = 0;
+        for (const QByteArray &line : frameHashes.readAll().split('\n')) {
+            if (line.isEmpty() || line.startsWith('#')) continue;
+            QList<QByteArray> fields = line.split(',');
+            if (fields.size() < 6) continue;
+
+            QJsonObject frame;
+            frame["index"] = index;
+            if (frameName) {
+                frame["file"] = frameName(index + 1); // image2 numbers files from 1
+            }
+            frame["pts"] = fields.at(2).trimmed().toLongLong();
+            frame["size"] = fields.at(4).trimmed().toLongLong();
+            frame["md5"] = QString::fromLatin1(fields.at(5).trimmed());
+            frames.append(frame);
+            ++index;
+        }
+        frameHashes.close();
+
+        QString hashLine = QString::fromLatin1(streamHash.readAll()).trimmed();
+        streamHash.close();
+
+        QJsonObject manifest;
+        manifest["output"] = outputPath;
+        manifest["frameAlgorithm"] = "md5";
+        manifest["streamAlgorithm"] = "sha256";
+        manifest["streamHash"] = hashLine.section('=', 1);
+        manifest["frames"] = frames;
+
+        QFile file(manifestPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            error = QString("Failed to write checksum manifest: %1").arg(manifestPath);
+            return false;
+        }
+        file.write(QJsonDocument(manifest).toJson());
+        file.close();
+
+        frameHashes.remove();
+        streamHash.remove();
+        return true;
+    };
 }
 
-QStringList Converter::findImageFiles(const QString &directory)
+QStringList Converter::buildSequenceInputArguments(const QStringList &imageFiles, int first, int count, int frameRate) const
 {
-    QDir dir(directory);
-    QStringList nameFilters;
-    nameFilters << "*.jpg" << "*.jpeg" << "*.png" << "*.tiff" << "*.tif" 
-                << "*.bmp" << "*.exr" << "*.hdr" << "*.pic" << "*.ppm";
-    
-    QStringList imageFiles = dir.entryList(nameFilters, QDir::Files, QDir::Name);
-    
-    // Convert to absolute paths
-    QStringList absolutePaths;
-    for (const QString &fileName : imageFiles) {
-        absolutePaths.append(dir.absoluteFilePath(fileName));
+    QStringList args;
+    args << "-framerate" << QString::number(frameRate);
+    QFileInfo fileInfo(imageFiles.at(first));
+    QString baseName = fileInfo.completeBaseName();
+    QString extension = fileInfo.suffix();
+
+    QString prefix;
+    int number = 0;
+    int padding = 0;
+    bool sharded = fileInfo.path() != QFileInfo(imageFiles.at(first + count - 1)).path();
+    // A glob has no start number; image2 seeks it by index, which skips to the first frame wanted
+    auto seekToFirst = [&args, first, frameRate]() {
+        if (first > 0) {
+            args << "-ss" << QString::number(double(first) / qMax(1, frameRate), 'f', 6);
+        }
+    };
+    if (sharded && parseFrameNumber(baseName, prefix, number, padding)) {
+        // Shards sort by name like the frames in them, so one glob over all of them is in order
+        seekToFirst();
+        args << "-pattern_type" << "glob";
+        QDir shardRoot(QFileInfo(fileInfo.absolutePath()).absolutePath());
+        args << "-i" << shardRoot.absoluteFilePath(QString("*/%1*.%2").arg(prefix, extension));
+    } else if (parseFrameNumber(baseName, prefix, number, padding)) {
+        args << "-start_number" << QString::number(number);
+        args << "-i" << fileInfo.dir().absoluteFilePath(
+            QString("%1%%2d.%3").arg(prefix).arg(padding, 2, 10, QChar('0')).arg(extension));
+    } else {
+        // Unnumbered names sort the same way for the glob as for findImageFiles
+        seekToFirst();
+        args << "-pattern_type" << "glob";
+        args << "-i" << fileInfo.dir().absoluteFilePath(QString("*.%1").arg(extension));
     }
-    
-    return absolutePaths;
+
+    if (count < imageFiles.size()) {
+        args << "-frames:v" << QString::number(count);
+    }
+    return args;
 }
 
-void Converter::cancel()
+QStringList Converter::buildPipeInputArguments(const ConversionSettings &settings, const QString &extension) const
 {
-    if (ffmpegProcess && isProcessing) {
-        ffmpegProcess->kill();
-        emit logMessage("Conversion cancelled by user.");
-    }
+    // image2pipe cannot probe every format reliably, so name the decoder explicitly
+    QString lower = extension.toLower();
+    QString decoder = "png";
+    if (lower == "jpg" || lower == "jpeg") decoder = "mjpeg";
+    else if (lower == "tif" || lower == "tiff") decoder = "tiff";
+    else if (lower == "bmp") decoder = "bmp";
+    else if (lower == "exr") decoder = "exr";
+    else if (lower == "hdr" || lower == "pic") decoder = "hdr";
+    else if (lower == "ppm") decoder = "ppm";
+
+    QStringList args;
+    args << "-f" << "image2pipe";
+    args << "-framerate" << QString::number(settings.frameRate);
+    args << "-c:v" << decoder;
+    args << "-i" << "-";
+    return args;
 }
 
-void Converter::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+QStringList Converter::buildVideoEncodeArguments(const ConversionSettings &settings)
 {
-    isProcessing = false;
-    
-    if (ffmpegProcess) {
-        ffmpegProcess->deleteLater();
-        ffmpegProcess = nullptr;
+    QStringList args;
+
+    QString codecName = getVideoCodecName(settings.videoCodec);
+    args << speedTierArguments(codecName, settings);
+
+    QString pixelFormat = settings.pixelFormat;
+    if (pixelFormat.isEmpty()) {
+        const CodecRegistry::CodecInfo *codec = CodecRegistry::codecForLabel(settings.videoCodec);
+        if (codec) pixelFormat = CodecRegistry::pixelFormatInfo(codec->defaultPixelFormat).name;
     }
-    
-    if (exitStatus == QProcess::CrashExit) {
-        emit finished(false, "FFmpeg process crashed.");
-        return;
+    if (!pixelFormat.isEmpty()) {
+        args << "-pix_fmt" << pixelFormat;
     }
-    
-    if (exitCode == 0) {
-        emit progressChanged(100);
-        emit finished(true, "Conversion completed successfully!");
+    if (settings.threads > 0) {
+        args << "-threads" << QString::number(settings.threads);
+    }
+
+    if (settings.maintainAspectRatio) {
+        args << "-vf" << QString("scale=%1:%2:force_original_aspect_ratio=decrease,pad=%1:%2:(ow-iw)/2:(oh-ih)/2")
+                         .arg(settings.width).arg(settings.height);
     } else {
-        emit finished(false, QString("Conversion failed with exit code %1").arg(exitCode));
+        args << "-s" << QString("%1x%2").arg(settings.width).arg(settings.height);
     }
+
+    return args;
 }
 
-void Converter::onProcessError(QProcess::ProcessError error)
+QStringList Converter::buildRemuxArguments(const ConversionSettings &settings, const VideoInfo &source)
 {
-    isProcessing = false;
-    
-    QString errorString;
-    switch (error) {
-        case QProcess::FailedToStart:
-            errorString = "Failed to start FFmpeg. Please check if FFmpeg is installed.";
-            break;
-        case QProcess::Crashed:
-            errorString = "FFmpeg process crashed.";
-            break;
-        case QProcess::Timedout:
-            errorString = "FFmpeg process timed out.";
-            break;
-        case QProcess::WriteError:
-            errorString = "Write error occurred.";
-            break;
-        case QProcess::ReadError:
-            errorString = "Read error occurred.";
-            break;
-        default:
-            errorString = "Unknown error occurred.";
-            break;
+    QStringList args;
+    args << "-i" << settings.inputPath;
+    // First video and audio stream, the ones the probe looked at; data and subtitle streams often don't fit
+    args << "-map" << "0:v:0";
+    if (!source.audioCodec.isEmpty()) args << "-map" << "0:a:0";
+
+    const CodecRegistry::ContainerInfo *container = CodecRegistry::containerForName(settings.videoFormat);
+    if (canStreamCopy(source.codec, settings.videoFormat)) {
+        args << "-c:v" << "copy";
+        // Apple players only accept HEVC in MP4/MOV under the hvc1 tag
+        bool isoMedia = container && (container->id == CodecRegistry::Container::MP4 || container->id == CodecRegistry::Container::MOV);
+        if (source.codec == "hevc" && isoMedia) args << "-tag:v" << "hvc1";
+    } else {
+        // Fallback: re-encode at the source size with the selected codec
+        ConversionSettings encode = settings;
+        encode.width = source.width;
+        encode.height = source.height;
+        encode.maintainAspectRatio = false;
+        args << buildVideoEncodeArguments(encode);
+    }
+    if (source.audioCodec.isEmpty()) {
+        args << "-an";
+    } else if (container && CodecRegistry::canCopyAudio(source.audioCodec, *container)) {
+        args << "-c:a" << "copy";
+    } else {
+        args << "-c:a" << (container ? container->audioEncoder : "aac");
     }
-    
-    emit finished(false, errorString);
-}
 
-void Converter::onProcessOutput()
-{
-    if (!ffmpegProcess) return;
-    
-    QByteArray data = ffmpegProcess->readAllStandardError();
-    QString output = QString::fromUtf8(data);
-    
-    emit logMessage(output);
-    parseProgress(output);
+    args << "-f" << muxerName(settings.videoFormat);
+    args << "-y" << settings.outputPath;
+    return args;
 }
 
-void Converter::parseProgress(const QString &output)
+QStringList Converter::speedTierArguments(const QString &codecName, const ConversionSettings &settings) const
 {
-    // Parse FFmpeg progress output
-    static QRegularExpression frameRegex("frame=\\s*(\\d+)");
+    QStringList args;
+    const QString tier = settings.speedTier;
+
+    if (codecName == "libx264" || codecName == "libx265") {
+        args << "-c:v" << codecName;
+        args << "-crf" << QString::number(settings.quality);
+
+        // An auto-tuned preset is more specific than the tier
+        QString preset = settings.encoderPreset;
+        if (preset.isEmpty()) {
+            if (tier == "Draft") preset = codecName == "libx264" ? "veryfast" : "superfast";
+            else if (tier == "Archive") preset = "slow";
+            else preset = "medium";
+        }
+        args << "-preset" << preset;
+    } else if (codecName == "libvpx-vp9") {
+        // libvpx is single-threaded per tile unless row-mt and tile columns are set
+        int tileColumns = 0;
+        while (tileColumns < 6 && (256 << (tileColumns + 1)) <= settings.width) {
+            ++tileColumns;
+        }
+
+        args << "-c:v" << codecName;
+        args << "-b:v" << "0";
+        args << "-crf" << QString::number(qBound(0, qRound(settings.quality * 63.0 / 51.0), 63));
+        args << "-row-mt" << "1";
+        args << "-tile-columns" << QString::number(tileColumns);
+        if (tier == "Draft") {
+            args << "-deadline" << "realtime" << "-cpu-used" << "8";
+        } else if (tier == "Archive") {
+            args << "-deadline" << "good" << "-cpu-used" << "1";
+            args << "-auto-alt-ref" << "1" << "-lag-in-frames" << "25";
+        } else {
+            args << "-deadline" << "good" << "-cpu-used" << "4";
+        }
+    } else if (codecName == "prores") {
+        // prores (prores_aw) is the fast encoder; prores_ks is slower but closer to Apple's output
+        if (tier == "Draft") {
+            args << "-c:v" << "prores" << "-profile:v" << "0"; // Proxy
+        } else if (tier == "Archive") {
+            args << "-c:v" << "prores_ks" << "-profile:v" << "3"; // HQ
+        } else {
+            args << "-c:v" << "prores_ks" << "-profile:v" << "2"; // Standard
+        }
+    } else if (codecName == "mjpeg") {
+        // JPEG quantizer scale: 2 is best, 31 worst; map the 0-51 CRF range onto it
+        args << "-c:v" << codecName;
+        args << "-q:v" << QString::number(qBound(2, 2 + qRound(settings.quality * 29.0 / 51.0), 31));
+    } else {
+        args << "-c:v" << codecName;
+    }
+
+    return args;
+}
+
+QString Converter::outputExtension(const ConversionSettings &settings)
+{
+    if (settings.streamingMode == "HLS") return "m3u8";
+    if (settings.streamingMode == "DASH") return "mpd";
+    const CodecRegistry::ContainerInfo *container = CodecRegistry::containerForName(settings.videoFormat);
+    return container ? QString::fromLatin1(container->extension) : settings.videoFormat.toLower();
+}
+
+QStringList Converter::buildStreamingArguments(const ConversionSettings &settings) const
+{
+    QStringList args;
+    const int segmentDuration = qMax(1, settings.segmentDuration);
+    const QFileInfo outputInfo(settings.outputPath);
+    const QString baseName = outputInfo.completeBaseName();
+
+    // Keyframes on segment boundaries so every segment/fragment is independently playable
+    args << "-force_key_frames" << QString("expr:gte(t,n_forced*%1)").arg(segmentDuration);
+
+    if (settings.streamingMode == "HLS") {
+        args << "-f" << "hls";
+        args << "-hls_time" << QString::number(segmentDuration);
+        args << "-hls_playlist_type" << "event";
+        args << "-hls_segment_type" << "fmp4";
+        args << "-hls_fmp4_init_filename" << baseName + "_init.mp4";
+        args << "-hls_segment_filename" << outputInfo.dir().absoluteFilePath(baseName + "_%05d.m4s");
+    } else if (settings.streamingMode == "DASH") {
+        args << "-f" << "dash";
+        args << "-seg_duration" << QString::number(segmentDuration);
+        args << "-use_template" << "1";
+        args << "-use_timeline" << "1";
+        args << "-init_seg_name" << baseName + "_init_$RepresentationID$.m4s";
+        args << "-media_seg_name" << baseName + "_chunk_$RepresentationID$_$Number%05d$.m4s";
+    } else {
+        // Fragmented MP4: moov up front, one fragment per keyframe
+        args << "-movflags" << "+frag_keyframe+empty_moov+default_base_moof";
+        args << "-f" << muxerName(settings.videoFormat);
+    }
+
+    return args;
+}
+
+void Converter::startFollowing()
+{
+    follow = FollowState();
+    follow.idleTimer.start();
+    totalFrames = 0;
+    framesCompleted = 0;
+    isProcessing = true;
+
+    followTimer = new QTimer(this);
+    followTimer->setInterval(250);
+    connect(followTimer, &QTimer::timeout, this, &Converter::onFollowTick);
+    followTimer->start();
+    onFollowTick();
+}
+
+void Converter::stopFollowing()
+{
+    if (followTimer) {
+        followTimer->stop();
+        followTimer->deleteLater();
+        followTimer = nullptr;
+    }
+}
+
+QString Converter::followFramePath(int number) const
+{
+    return follow.directory.absoluteFilePath(QString("%1%2.%3")
+        .arg(follow.prefix)
+        .arg(number, follow.padding, 10, QChar('0'))
+        .arg(follow.extension));
+}
+
+void Converter::onFollowTick()
+{
+    // Bound what sits in the stdin buffer so a slow encoder doesn't pull the whole sequence into memory
+    const qint64 maxPendingBytes = 256 * 1024 * 1024;
+    const qint64 timeoutMs = qint64(qMax(1, currentSettings.followTimeout)) * 1000;
+
+    if (!follow.started) {
+        QStringList imageFiles = findImageFiles(currentSettings.inputPath);
+        if (imageFiles.isEmpty()) {
+            if (follow.idleTimer.elapsed() > timeoutMs) {
+                stopFollowing();
+                isProcessing = false;
+                emit finished(false, "No frames appeared in the selected directory before the follow timeout.");
+            }
+            return;
+        }
+
+        QFileInfo firstFrame(imageFiles.first());
+        int number = 0;
+        if (!parseFrameNumber(firstFrame.completeBaseName(), follow.prefix, number, follow.padding)) {
+            stopFollowing();
+            isProcessing = false;
+            emit finished(false, "Follow mode needs numbered frames (e.g. shot_0001.exr).");
+            return;
+        }
+        follow.directory = firstFrame.dir();
+        follow.extension = firstFrame.suffix();
+        follow.nextNumber = number;
+        follow.started = true;
+
+        emit logMessage("Starting conversion...");
+        if (currentSettings.streamingMode == "HLS" || currentSettings.streamingMode == "DASH") {
+            watchStreamingSegments();
+        }
+        marks.step = "follow encode";
+        startProcess(buildFFmpegArguments(currentSettings, true));
+    }
+
+    if (!ffmpegProcess) return;
+
+    while (ffmpegProcess->bytesToWrite() < maxPendingBytes) {
+        QFileInfo frameInfo(followFramePath(follow.nextNumber));
+        if (!frameInfo.exists()) break;
+
+        // A frame is complete once the renderer has moved on, or its size held still for a poll
+        bool successorExists = QFileInfo::exists(followFramePath(follow.nextNumber + 1));
+        if (!successorExists && (frameInfo.size() == 0 || frameInfo.size() != follow.candidateSize)) {
+            follow.candidateSize = frameInfo.size();
+            break;
+        }
+
+        QFile frame(frameInfo.absoluteFilePath());
+        if (!frame.open(QIODevice::ReadOnly)) break;
+        ffmpegProcess->write(frame.readAll());
+        frame.close();
+
+        follow.nextNumber++;
+        follow.candidateSize = -1;
+        follow.framesStreamed++;
+        follow.idleTimer.restart();
+        if (follow.framesStreamed % 100 == 0) {
+            emit logMessage(QString("Streamed %1 frames to the encoder").arg(follow.framesStreamed));
+        }
+    }
+
+    if (follow.idleTimer.elapsed() > timeoutMs) {
+        emit logMessage(QString("No new frame for %1 s, finishing after %2 frames.")
+                        .arg(currentSettings.followTimeout).arg(follow.framesStreamed));
+        stopFollowing();
+        ffmpegProcess->closeWriteChannel();
+    }
+}
+
+void Converter::watchStreamingSegments()
+{
+    stopWatchingSegments();
+    segmentsReported = 0;
+
+    QString outputDir = QFileInfo(currentSettings.outputPath).absolutePath();
+    segmentWatcher = new QFileSystemWatcher(this);
+    segmentWatcher->addPath(outputDir);
+    connect(segmentWatcher, &QFileSystemWatcher::directoryChanged, this, &Converter::onSegmentDirectoryChanged);
+}
+
+void Converter::stopWatchingSegments()
+{
+    if (segmentWatcher) {
+        segmentWatcher->deleteLater();
+        segmentWatcher = nullptr;
+    }
+}
+
+void Converter::onSegmentDirectoryChanged()
+{
+    int count = 0;
+
+    if (currentSettings.streamingMode == "HLS") {
+        // A segment is only listed in the playlist once it has been fully written
+        QFile playlist(currentSettings.outputPath);
+        if (!playlist.open(QIODevice::ReadOnly)) return;
+        count = playlist.readAll().count("#EXTINF");
+        playlist.close();
+    } else {
+        // DASH rewrites the manifest after each segment; the newest file may still be growing
+        QFileInfo outputInfo(currentSettings.outputPath);
+        QStringList segments = outputInfo.dir().entryList(
+            {outputInfo.completeBaseName() + "_chunk_*.m4s"}, QDir::Files);
+        count = isProcessing ? qMax(0, static_cast<int>(segments.size()) - 1) : segments.size();
+    }
+
+    if (count > segmentsReported) {
+        segmentsReported = count;
+        emit segmentsAvailable(count, currentSettings.outputPath);
+    }
+}
+
+bool Converter::prepareIncrementalEncode(const QStringList &imageFiles, QString &error)
+{
+    const int segmentLength = qMax(1, currentSettings.segmentLength);
+    const QString extension = outputExtension(currentSettings);
+    const QString muxer = muxerName(currentSettings.videoFormat);
+    const QStringList encodeArgs = buildVideoEncodeArguments(currentSettings);
+    const CodecRegistry::CodecInfo *codec = CodecRegistry::codecForLabel(currentSettings.videoCodec);
+    const CodecRegistry::Gop gop = codec ? codec->gop : CodecRegistry::Gop::Keyframes;
+
+    QDir segmentDir(currentSettings.outputPath + ".segments");
+    if (!segmentDir.exists() && !segmentDir.mkpath(".")) {
+        error = QString("Failed to create segment directory: %1").arg(segmentDir.absolutePath());
+        return false;
+    }
+
+    // Anything that changes the encoded bitstream invalidates every segment
+    QString settingsKey = QString::fromLatin1(QCryptographicHash::hash(
+        (encodeArgs.join(" ") + QString(" -framerate %1 -segment %2").arg(currentSettings.frameRate).arg(segmentLength)).toUtf8(),
+        QCryptographicHash::Sha1).toHex());
+
+    QStringList previousFingerprints;
+    QFile manifestFile(segmentDir.absoluteFilePath("manifest.json"));
+    if (manifestFile.open(QIODevice::ReadOnly)) {
+        QJsonObject manifest = QJsonDocument::fromJson(manifestFile.readAll()).object();
+        manifestFile.close();
+        if (manifest["settingsKey"].toString() == settingsKey) {
+            for (const QJsonValue &value : manifest["segments"].toArray()) {
+                previousFingerprints.append(value.toObject()["fingerprint"].toString());
+            }
+        }
+    }
+
+    const int segmentCount = (imageFiles.size() + segmentLength - 1) / segmentLength;
+    QStringList fingerprints;
+    QStringList segmentFiles;
+    int dirtyFrames = 0;
+
+    for (int segment = 0; segment < segmentCount; ++segment) {
+        const int first = segment * segmentLength;
+        const int count = qMin(segmentLength, static_cast<int>(imageFiles.size()) - first);
+
+        // Fingerprint frames by name, size and mtime so unchanged frames are never re-read
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        for (int i = first; i < first + count; ++i) {
+            QFileInfo frameInfo(imageFiles.at(i));
+            hash.addData(QString("%1|%2|%3\n").arg(frameInfo.fileName())
+                         .arg(frameInfo.size())
+                         .arg(frameInfo.lastModified().toMSecsSinceEpoch()).toUtf8());
+        }
+        QString fingerprint = QString::fromLatin1(hash.result().toHex());
+        fingerprints.append(fingerprint);
+
+        QString segmentFile = QString("seg_%1.%2").arg(segment, 5, 10, QChar('0')).arg(extension);
+        segmentFiles.append(segmentFile);
+
+        bool dirty = segment >= previousFingerprints.size()
+                     || previousFingerprints.at(segment) != fingerprint
+                     || !segmentDir.exists(segmentFile);
+        if (!dirty) continue;
+
+        ConversionStep step;
+        step.arguments << buildSequenceInputArguments(imageFiles, first, count, currentSettings.frameRate);
+        step.arguments << encodeArgs;
+        // One GOP per segment so segments can be joined with stream copy
+        step.arguments << "-g" << QString::number(segmentLength);
+        step.arguments << "-keyint_min" << QString::number(segmentLength);
+        if (gop == CodecRegistry::Gop::ClosedGop) step.arguments << "-flags" << "+cgop";
+        step.arguments << "-an";
+        step.arguments << "-f" << muxer;
+        step.arguments << "-y" << segmentDir.absoluteFilePath(segmentFile);
+        step.description = QString("Encoding segment %1/%2 (frames %3-%4)...")
+                           .arg(segment + 1).arg(segmentCount).arg(first).arg(first + count - 1);
+        step.frames = count;
+        step.firstFrame = first;
+        pendingSteps.append(step);
+        dirtyFrames += count;
+    }
+
+    // Drop segments left over from a longer previous version of the sequence
+    for (const QString &stale : segmentDir.entryList({"seg_*"}, QDir::Files)) {
+        if (!segmentFiles.contains(stale)) {
+            segmentDir.remove(stale);
+        }
+    }
+
+    if (pendingSteps.isEmpty() && QFileInfo::exists(currentSettings.outputPath)) {
+        emit logMessage(QString("All %1 segments unchanged.").arg(segmentCount));
+        return true;
+    }
+
+    emit logMessage(QString("%1 of %2 segments need re-encoding (%3 of %4 frames).")
+                    .arg(pendingSteps.size()).arg(segmentCount).arg(dirtyFrames).arg(imageFiles.size()));
+
+    QFile concatFile(segmentDir.absoluteFilePath("segments.ffconcat"));
+    if (!concatFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        error = QString("Failed to write segment list: %1").arg(concatFile.fileName());
+        return false;
+    }
+    concatFile.write("ffconcat version 1.0\n");
+    for (const QString &segmentFile : segmentFiles) {
+        concatFile.write(QString("file '%1'\n").arg(segmentFile).toUtf8());
+    }
+    concatFile.close();
+
+    ConversionStep concatStep;
+    concatStep.arguments << "-f" << "concat" << "-safe" << "0";
+    concatStep.arguments << "-i" << concatFile.fileName();
+    concatStep.arguments << "-c" << "copy";
+    if (currentSettings.writeChecksums) {
+        concatStep.arguments << buildChecksumOutputArguments(muxer, currentSettings.outputPath, currentSettings.outputPath);
+    } else {
+        concatStep.arguments << "-f" << muxer;
+        concatStep.arguments << "-y" << currentSettings.outputPath;
+    }
+    concatStep.description = "Joining segments with stream copy...";
+    concatStep.frames = 0;
+    pendingSteps.append(concatStep);
+
+    totalFrames = dirtyFrames;
+
+    // The manifest is only written once the output is complete, so a failed run re-encodes
+    QString manifestPath = manifestFile.fileName();
+    auto previous = finalizeStep;
+    finalizeStep = [previous, manifestPath, settingsKey, segmentLength, fingerprints, segmentFiles](QString &finalizeError) {
+        if (previous && !previous(finalizeError)) return false;
+
+        QJsonArray segments;
+        for (int i = 0; i < fingerprints.size(); ++i) {
+            QJsonObject segment;
+            segment["file"] = segmentFiles.at(i);
+            segment["fingerprint"] = fingerprints.at(i);
+            segments.append(segment);
+        }
+        QJsonObject manifest;
+        manifest["settingsKey"] = settingsKey;
+        manifest["segmentLength"] = segmentLength;
+        manifest["segments"] = segments;
+
+        QFile file(manifestPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            finalizeError = QString("Failed to write segment manifest: %1").arg(manifestPath);
+            return false;
+        }
+        file.write(QJsonDocument(manifest).toJson());
+        file.close();
+        return true;
+    };
+
+    return true;
+}
+
+QString Converter::getVideoCodecName(const QString &codec)
+{
+    const CodecRegistry::CodecInfo *info = CodecRegistry::codecForLabel(codec);
+    return info ? QString::fromLatin1(info->encoder) : QString("libx264");
+}
+
+QString Converter::muxerName(const QString &format)
+{
+    const CodecRegistry::ContainerInfo *container = CodecRegistry::containerForName(format);
+    return container ? QString::fromLatin1(container->muxer) : format.toLower();
+}
+
+QString Converter::validateSettings(const ConversionSettings &settings)
+{
+    QString error = CodecRegistry::validate(settings.videoCodec, settings.videoFormat, settings.pixelFormat);
+    if (!error.isEmpty()) return error;
+
+    const CodecRegistry::CodecInfo *codec = CodecRegistry::codecForLabel(settings.videoCodec);
+    const CodecRegistry::ContainerInfo *container = CodecRegistry::containerForName(settings.videoFormat);
+    if (settings.streamingMode == "Fragmented MP4"
+        && container->id != CodecRegistry::Container::MP4 && container->id != CodecRegistry::Container::MOV) {
+        return "Fragmented MP4 output needs the MP4 or MOV container.";
+    }
+    if ((settings.streamingMode == "HLS" || settings.streamingMode == "DASH")
+        && !CodecRegistry::isCompatible(*codec, *CodecRegistry::findContainer("mp4"))) {
+        return "HLS/DASH fMP4 segments cannot carry the selected codec.";
+    }
+    return QString();
+}
+
+// Splits "shot_0042.exr" into prefix "shot_", number 42 and padding 4
+bool Converter::parseFrameNumber(const QString &baseName, QString &prefix, int &number, int &padding)
+{
+    // Plain character scan: this runs once per file on the tree-scanner threads
+    int start = baseName.length();
+    while (start > 0 && baseName.at(start - 1) >= QLatin1Char('0') && baseName.at(start - 1) <= QLatin1Char('9')) --start;
+    if (start == baseName.length()) return false;
+
+    QString numberPart = baseName.mid(start);
+    prefix = baseName.left(baseName.length() - numberPart.length());
+    number = numberPart.toInt();
+    padding = numberPart.length();
+    return true;
+}
+
+bool Converter::canStreamCopy(const QString &sourceCodec, const QString &container)
+{
+    const CodecRegistry::CodecInfo *codec = CodecRegistry::codecForStream(sourceCodec);
+    const CodecRegistry::ContainerInfo *target = CodecRegistry::containerForName(container);
+    return codec && target && CodecRegistry::isCompatible(*codec, *target);
+}
+
+// MJPEG output from JPEG files at the output size needs no decode: image2 hands
+// the files over as MJPEG packets and they are muxed as they are
+bool Converter::canPassThroughJpeg(const ConversionSettings &settings, const QStringList &imageFiles)
+{
+    const CodecRegistry::CodecInfo *codec = CodecRegistry::codecForLabel(settings.videoCodec);
+    if (!codec || qstrcmp(codec->encoder, "mjpeg") != 0 || imageFiles.isEmpty()) return false;
+    if (settings.streamingMode != "None" || settings.incremental) return false;
+
+    for (const QString &file : imageFiles) {
+        QString suffix = QFileInfo(file).suffix().toLower();
+        if (suffix != "jpg" && suffix != "jpeg") return false;
+    }
+    // Only the headers are read; checking both ends catches a resized tail
+    QSize target(settings.width, settings.height);
+    return QImageReader(imageFiles.first()).size() == target && QImageReader(imageFiles.last()).size() == target;
+}
+
+QStringList Converter::imageExtensions()
+{
+    return {"jpg", "jpeg", "png", "tiff", "tif", "bmp", "exr", "hdr", "pic", "ppm"};
+}
+
+QStringList Converter::findImageFiles(const QString &directory, const std::function<bool()> &isCanceled)
+{
+    QStringList nameFilters;
+    for (const QString &extension : imageExtensions()) nameFilters << "*." + extension;
+    
+    // Iterate rather than entryList() so a scan of a huge network directory can be abandoned
+    QStringList absolutePaths;
+    QDirIterator it(QDir(directory).absolutePath(), nameFilters, QDir::Files);
+    while (it.hasNext()) {
+        if (isCanceled && isCanceled()) return QStringList();
+        absolutePaths.append(it.next());
+    }
+    
+    // No frames at the top: read a sharded extraction (numbered subdirectories) as one sequence
+    if (absolutePaths.isEmpty()) {
+        QDirIterator shards(QDir(directory).absolutePath(), QDir::Dirs | QDir::NoDotAndDotDot);
+        while (shards.hasNext()) {
+            QString shard = shards.next();
+            bool numeric = false;
+            shards.fileName().toLongLong(&numeric);
+            if (!numeric) continue;
+            QDirIterator frames(shard, nameFilters, QDir::Files);
+            while (frames.hasNext()) {
+                if (isCanceled && isCanceled()) return QStringList();
+                absolutePaths.append(frames.next());
+            }
+        }
+    }
+    
+    std::sort(absolutePaths.begin(), absolutePaths.end());
+    return absolutePaths;
+}
+
+void Converter::cancel()
+{
+    if (probeWatcher) {
+        // ffprobe runs to its end on the worker; its result is simply never used
+        probeWatcher->disconnect(this);
+        probeWatcher->deleteLater();
+        probeWatcher = nullptr;
+        isProcessing = false;
+        emit logMessage("Conversion cancelled by user.");
+        emit finished(false, "Conversion cancelled.");
+        return;
+    }
+
+    if (finalizeWatcher) {
+        // The move stops at its next frame; finished() follows from the watcher
+        if (!finalizeWatcher->isCanceled()) {
+            emit logMessage("Conversion cancelled by user.");
+            finalizeWatcher->cancel();
+        }
+        return;
+    }
+
+    if (tuner) {
+        emit logMessage("Auto-tuning cancelled by user.");
+        tuner->cancel();
+        return;
+    }
+    
+    if (transcoder) {
+        emit logMessage("Conversion cancelled by user.");
+        transcoder->cancel();
+        return;
+    }
+    
+    if (followTimer && !ffmpegProcess) {
+        // Still waiting for the first frame to appear
+        stopFollowing();
+        isProcessing = false;
+        emit logMessage("Conversion cancelled by user.");
+        emit finished(false, "Conversion cancelled.");
+        return;
+    }
+    
+    if (encodePool && !ffmpegProcess) {
+        // ffmpeg already finished; only the pool is still writing
+        stopRawExtraction();
+        isProcessing = false;
+        emit logMessage("Conversion cancelled by user.");
+        emit finished(false, "Conversion cancelled.");
+        return;
+    }
+    
+    if (ffmpegProcess && isProcessing) {
+        pendingSteps.clear();
+        stopFollowing();
+        ffmpegProcess->kill();
+        emit logMessage("Conversion cancelled by user.");
+    }
+}
+
+bool Converter::pause()
+{
+#ifdef Q_OS_UNIX
+    // Only a running encoder can be stopped; tuning and scans are short and not worth it
+    if (paused || !ffmpegProcess || ffmpegProcess->state() != QProcess::Running) return false;
+
+    paused = true;
+    pauseClock.start();
+    if (trace) marks.paused = trace->now();
+    applyStopState();
+    if (followTimer) followTimer->stop();
+    emit logMessage("Conversion paused.");
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Converter::resume()
+{
+#ifdef Q_OS_UNIX
+    if (!paused) return false;
+    paused = false;
+    pausedMs += pauseClock.elapsed();
+    traceSpan("paused", marks.paused);
+    marks.paused = -1;
+    applyStopState();
+    if (followTimer) {
+        // Time spent stopped must not count towards the follow timeout
+        follow.idleTimer.restart();
+        followTimer->start();
+    }
+    emit logMessage(QString("Conversion resumed after %1 s paused.").arg(pauseClock.elapsed() / 1000.0, 0, 'f', 1));
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Converter::applyStopState()
+{
+#ifdef Q_OS_UNIX
+    // The user's pause and pool back-pressure share one SIGSTOP
+    bool stop = paused || raw.throttled;
+    if (!ffmpegProcess || ffmpegProcess->state() != QProcess::Running || stop == processStopped) return;
+    if (::kill(static_cast<pid_t>(ffmpegProcess->processId()), stop ? SIGSTOP : SIGCONT) == 0) {
+        processStopped = stop;
+    }
+#endif
+}
+
+bool Converter::isPaused() const
+{
+    return paused;
+}
+
+qint64 Converter::pausedMilliseconds() const
+{
+    return pausedMs + (paused ? pauseClock.elapsed() : 0);
+}
+
+qint64 Converter::processId() const
+{
+    return ffmpegProcess ? ffmpegProcess->processId() : 0;
+}
+
+void Converter::probeInput(const QString &videoPath, bool withKeyframes,
+                           const std::function<void(const ProbeResult &)> &next)
+{
+    isProcessing = true; // nothing else may start while the probe runs
+    qint64 probeStart = trace ? trace->now() : -1;
+    probeWatcher = new QFutureWatcher<ProbeResult>(this);
+    connect(probeWatcher, &QFutureWatcher<ProbeResult>::finished, this, [this, next, probeStart]() {
+        ProbeResult probe = probeWatcher->result();
+        probeWatcher->deleteLater();
+        probeWatcher = nullptr;
+        traceSpan("probe", probeStart);
+        next(probe);
+    });
+    QString ffmpeg = ffmpegPath;
+    probeWatcher->setFuture(QtConcurrent::run([ffmpeg, videoPath, withKeyframes]() {
+        return VideoProbe::probeAll(ffmpeg, videoPath, withKeyframes);
+    }));
+}
+
+bool Converter::startRawExtraction(const ConversionSettings &settings, const ProbeResult &probe, QString &error)
+{
+    if (!probe.ok) {
+        error = probe.error;
+        return false;
+    }
+    const VideoInfo &info = probe.info;
+
+    totalFrames = settings.extractAllFrames ? info.frameCount : settings.endFrame - settings.startFrame + 1;
+    raw = RawExtractState();
+    raw.threads = settings.encodeThreads > 0 ? settings.encodeThreads
+                  : settings.threads > 0 ? settings.threads : QThread::idealThreadCount();
+
+    QByteArray format = settings.imageFormat.toLower().toLatin1();
+    if (format == "jpeg") format = "jpg";
+    if (format == "tif") format = "tiff";
+    encodePool = new ImageEncodePool(info.width, info.height, raw.threads, this);
+    FrameNaming naming(settings, totalFrames);
+    if (!settings.frameArchive && !naming.createShards(totalFrames, error)) {
+        delete encodePool;
+        encodePool = nullptr;
+        return false;
+    }
+    encodePool->setOutput(settings.outputPath, [naming](int number) { return naming.relativePath(number); },
+                          format, settings.compressionLevel, settings.writeChecksums);
+    if (settings.frameArchive) {
+        archiveWriter = new FrameArchiveWriter;
+        if (!archiveWriter->open(settings.outputPath, format, error)) {
+            stopRawExtraction();
+            return false;
+        }
+        encodePool->setArchive(archiveWriter);
+    }
+    connect(encodePool, &ImageEncodePool::bufferReleased, this, &Converter::onEncodeBufferReleased);
+    connect(encodePool, &ImageEncodePool::frameWritten, this, &Converter::onRawFrameWritten);
+
+    // ffmpeg only decodes; -noautorotate keeps the frame size the probe reported
+    QStringList args;
+    args << "-noautorotate" << "-i" << settings.inputPath;
+    if (settings.dedupFrames) {
+        beginDedup(settings, info, naming);
+        args << dedupFilterArguments(settings);
+    } else if (!settings.extractAllFrames) {
+        args << "-vf" << rangeFilter(settings);
+    }
+    args << "-an" << "-f" << "rawvideo" << "-pix_fmt" << "rgb24" << "-";
+
+    emit logMessage(QString("Starting video extraction: %1x%2, %3 encode threads...")
+                    .arg(info.width).arg(info.height).arg(raw.threads));
+    marks.step = "decode";
+    startProcess(args);
+    ffmpegProcess->setReadChannel(QProcess::StandardOutput);
+    connect(ffmpegProcess, &QProcess::readyReadStandardOutput, this, &Converter::onRawVideoOutput);
+    return true;
+}
+
+bool Converter::prepareSampledExtraction(const ConversionSettings &settings, const ProbeResult &probe, QString &error)
+{
+    if (!probe.ok) {
+        error = probe.error;
+        return false;
+    }
+    const VideoInfo &info = probe.info;
+    if (info.frameRate <= 0.0 || info.frameCount <= 0) {
+        error = QString("Cannot sample %1: its frame rate or frame count is unknown.").arg(settings.inputPath);
+        return false;
+    }
+
+    int first = settings.extractAllFrames ? 0 : qBound(0, settings.startFrame, info.frameCount - 1);
+    int last = settings.extractAllFrames ? info.frameCount - 1 : qBound(first, settings.endFrame, info.frameCount - 1);
+    double fps = info.frameRate;
+    auto seconds = [](double time) { return QString::number(time, 'f', 6); };
+
+    // Pick the source frames first; the output names are sized by how many there are
+    QList<int> frames;     // source frame numbers, in output order
+    QList<double> times;
+    bool keyframes = settings.samplingMode == "Keyframes";
+    if (keyframes) {
+        for (double time : probe.keyframes) {
+            if (time < first / fps - 0.5 / fps || time >= (last + 1) / fps) continue;
+            times << time;
+            frames << qRound(time * fps);
+        }
+        if (frames.isEmpty()) {
+            error = "No keyframes in the selected range.";
+            return false;
+        }
+    } else {
+        int span = last - first + 1;
+        if (settings.samplingMode == "Every Nth") {
+            for (int frame = first; frame <= last; frame += qMax(1, settings.sampleInterval)) frames << frame;
+        } else {
+            // Each sample is the middle of an equal share of the range
+            int count = qBound(1, settings.sampleCount, span);
+            for (int i = 0; i < count; ++i) frames << first + int((i + 0.5) * span / count);
+        }
+        for (int frame : frames) times << frame / fps;
+    }
+
+    FrameNaming naming(settings, frames.size());
+    // Samples further apart than about a GOP are cheaper to seek to than to decode through
+    bool seek = settings.samplingMode == "Evenly Spaced"
+                || (!keyframes && settings.sampleInterval >= qRound(fps * 2));
+    if (keyframes) {
+        // The decoder skips everything but keyframes, so nothing in between is ever decoded
+        ConversionStep step;
+        step.arguments << "-skip_frame" << "nokey";
+        if (!settings.extractAllFrames) {
+            step.arguments << "-ss" << seconds(first / fps) << "-t" << seconds((last + 1 - first) / fps);
+        }
+        step.arguments << "-i" << settings.inputPath << "-fps_mode" << "passthrough" << "-an" << "-y"
+                       << naming.ffmpegPattern();
+        step.description = QString("Extracting %1 keyframes...").arg(frames.size());
+        step.frames = frames.size();
+        pendingSteps << step;
+    } else if (!seek) {
+        ConversionStep step;
+        if (first > 0) step.arguments << "-ss" << seconds(times.first());
+        step.arguments << "-i" << settings.inputPath;
+        step.arguments << "-vf" << QString("select=not(mod(n\\,%1))").arg(settings.sampleInterval);
+        step.arguments << "-frames:v" << QString::number(frames.size());
+        step.arguments << "-fps_mode" << "passthrough" << "-an" << "-y" << naming.ffmpegPattern();
+        step.description = QString("Extracting one frame in %1...").arg(settings.sampleInterval);
+        step.frames = frames.size();
+        pendingSteps << step;
+    } else {
+        // One ffmpeg per batch: each sample is its own input opened at an accurate seek
+        if (!naming.createShards(frames.size(), error)) return false;
+        const int batchSize = 16;
+        for (int start = 0; start < frames.size(); start += batchSize) {
+            int count = qMin(batchSize, int(frames.size()) - start);
+            ConversionStep step;
+            if (settings.threads > 0) step.arguments << "-threads" << QString::number(settings.threads);
+            for (int i = 0; i < count; ++i) {
+                step.arguments << "-ss" << seconds(times.at(start + i)) << "-i" << settings.inputPath;
+            }
+            for (int i = 0; i < count; ++i) {
+                step.arguments << "-map" << QString("%1:v:0").arg(i) << "-frames:v" << "1" << "-update" << "1"
+                               << "-an" << "-y" << naming.filePath(start + i + 1);
+            }
+            step.description = QString("Seeking to samples %1-%2 of %3...")
+                               .arg(start + 1).arg(start + count).arg(frames.size());
+            step.frames = count;
+            pendingSteps << step;
+        }
+    }
+    totalFrames = frames.size();
+    if (!seek) addShardFinalizeStep(naming);
+
+    // The manifest ties each file back to the source frame it came from
+    QJsonArray entries;
+    for (int i = 0; i < frames.size(); ++i) {
+        entries.append(QJsonObject{{"file", naming.relativePath(i + 1)},
+                                   {"frame", frames.at(i)},
+                                   {"time", times.at(i)}});
+    }
+    QJsonObject manifest{{"source", settings.inputPath}, {"mode", settings.samplingMode},
+                         {"frameRate", fps}, {"frames", entries}};
+    QString manifestPath = QDir(settings.outputPath).absoluteFilePath("frames.json");
+    auto previous = finalizeStep;
+    finalizeStep = [previous, manifest, manifestPath](QString &error) {
+        if (previous && !previous(error)) return false;
+        QSaveFile file(manifestPath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(manifest).toJson()) < 0 || !file.commit()) {
+            error = QString("Failed to write frame manifest: %1").arg(manifestPath);
+            return false;
+        }
+        return true;
+    };
+
+    emit logMessage(QString("Sampling %1 of %2 frames (%3).").arg(frames.size()).arg(last - first + 1).arg(settings.samplingMode));
+    return true;
+}
+
+void Converter::addShardFinalizeStep(const FrameNaming &naming)
+{
+    if (!naming.isSharded()) return;
+    // The other finalizers only read sidecars and write manifests, so the moves can go first
+    backgroundFinalizeStep = [naming](QString &error, const std::function<bool()> &isCanceled) {
+        return naming.moveIntoShards(error, isCanceled);
+    };
+}
+
+QStringList Converter::dedupFilterArguments(const ConversionSettings &settings) const
+{
+    // mpdecimate drops frames that barely differ from the last one kept and showinfo reports the
+    // rest on stderr. Times start at 0 so they convert straight to frames; a range is cut by frame
+    // number. passthrough keeps the muxer from duplicating the dropped frames back in.
+    QString chain = "mpdecimate,showinfo";
+    chain.prepend(settings.extractAllFrames ? QString("setpts=PTS-STARTPTS,") : rangeFilter(settings) + ",");
+    return {"-vf", chain, "-fps_mode", "passthrough"};
+}
+
+QString Converter::rangeFilter(const ConversionSettings &settings)
+{
+    // startFrame/endFrame are frame numbers; -ss would read them as seconds
+    return QString("trim=start_frame=%1:end_frame=%2,setpts=PTS-STARTPTS")
+           .arg(settings.startFrame).arg(settings.endFrame + 1);
+}
+
+void Converter::beginDedup(const ConversionSettings &settings, const VideoInfo &info, const FrameNaming &naming)
+{
+    dedup = DedupState();
+    dedup.active = true;
+    dedup.frameRate = info.frameRate > 0 ? info.frameRate : double(qMax(1, settings.frameRate));
+    dedup.firstFrame = settings.extractAllFrames ? 0 : settings.startFrame;
+    dedup.originalFrames = settings.extractAllFrames ? info.frameCount : settings.endFrame - settings.startFrame + 1;
+    if (info.frameCount > 0) {
+        dedup.originalFrames = qMin(dedup.originalFrames, info.frameCount - dedup.firstFrame);
+    }
+    dedup.frameName = [naming](int number) { return naming.relativePath(number); };
+}
+
+QString Converter::takeDedupOutput(const QByteArray &data)
+{
+    // showinfo prints a line per kept frame; those go into the manifest instead of the log
+    static QRegularExpression frameRegex("\\sn:\\s*\\d+\\s.*\\spts_time:\\s*(-?[0-9.]+)");
+
+    dedup.pending += data;
+    QString passed;
+    qsizetype start = 0;
+    for (qsizetype i = 0; i < dedup.pending.size(); ++i) {
+        char c = dedup.pending.at(i);
+        if (c != '\n' && c != '\r') continue;
+        QByteArray line = dedup.pending.mid(start, i - start + 1);
+        start = i + 1;
+        if (!line.contains("Parsed_showinfo")) {
+            passed += QString::fromUtf8(line);
+            continue;
+        }
+        QRegularExpressionMatch match = frameRegex.match(QString::fromLatin1(line));
+        if (!match.hasMatch()) continue; // stream configuration and side data
+        int frame = dedup.firstFrame + qRound(match.captured(1).toDouble() * dedup.frameRate);
+        if (!dedup.kept.isEmpty() && frame <= dedup.kept.last()) {
+            frame = dedup.kept.last() + 1; // rounding on odd timestamps must not merge two runs
+        }
+        dedup.kept.append(frame);
+
+        int done = frame - dedup.firstFrame + 1;
+        emit frameProgress(done);
+        if (dedup.originalFrames > 0) {
+            emit progressChanged(qMin(100, done * 100 / dedup.originalFrames));
+        }
+    }
+    dedup.pending.remove(0, start);
+    return passed;
+}
+
+bool Converter::finishDedup(QString &error)
+{
+    if (!dedup.pending.isEmpty()) takeDedupOutput("\n"); // a last line without its newline
+    if (!dedup.kept.isEmpty()) {
+        // The container's frame count is only an estimate; the last kept frame is certain
+        dedup.originalFrames = qMax(dedup.originalFrames, dedup.kept.last() - dedup.firstFrame + 1);
+    }
+    if (!DedupManifest::write(currentSettings.outputPath, currentSettings.inputPath, dedup.frameRate,
+                              dedup.firstFrame, dedup.originalFrames, dedup.kept, dedup.frameName, error)) {
+        return false;
+    }
+    emit logMessage(QString("Kept %1 of %2 frames; %3 duplicates were dropped and recorded in %4.")
+                    .arg(dedup.kept.size()).arg(dedup.originalFrames)
+                    .arg(dedup.originalFrames - dedup.kept.size()).arg(QString::fromLatin1(DedupManifest::FileName)));
+    return true;
+}
+
+bool Converter::expandsDuplicates(const ConversionSettings &settings)
+{
+    return settings.expandDuplicates && !settings.followSequence && !settings.incremental
+           && DedupManifest::exists(settings.inputPath);
+}
+
+qint64 Converter::readRawVideo(char *data, qint64 maxSize)
+{
+    if (ffmpegProcess) return ffmpegProcess->read(data, maxSize);
+
+    qint64 size = qMin(maxSize, static_cast<qint64>(raw.backlog.size()) - raw.backlogOffset);
+    if (size <= 0) return 0;
+    memcpy(data, raw.backlog.constData() + raw.backlogOffset, size);
+    raw.backlogOffset += size;
+    return size;
+}
+
+void Converter::onRawVideoOutput()
+{
+    // Read straight into pooled frame buffers and hand each full frame to the pool
+    while (encodePool) {
+        if (raw.buffer < 0) {
+            raw.buffer = encodePool->acquireBuffer();
+            if (raw.buffer < 0) {
+                // Every buffer is queued for encoding; hold ffmpeg until some come back
+                raw.throttled = true;
+                applyStopState();
+                return;
+            }
+            raw.filled = 0;
+        }
+        qint64 read = readRawVideo(encodePool->bufferData(raw.buffer) + raw.filled, encodePool->frameBytes() - raw.filled);
+        if (read <= 0) break;
+        raw.filled += read;
+        if (raw.filled == encodePool->frameBytes()) {
+            encodePool->submit(raw.buffer, raw.nextFrame++);
+            raw.buffer = -1;
+        }
+    }
+    finishRawExtraction();
+}
+
+void Converter::onEncodeBufferReleased()
+{
+    if (!encodePool) return;
+    // Resume at half capacity rather than on every frame to avoid a stop/continue per frame
+    if (raw.throttled && encodePool->freeBuffers() >= encodePool->bufferCount() / 2) {
+        raw.throttled = false;
+        applyStopState();
+    }
+    onRawVideoOutput();
+}
+
+void Converter::onRawFrameWritten(int frameNumber, bool success, const QString &error)
+{
+    Q_UNUSED(frameNumber);
+    if (!encodePool) return;
+
+    if (!success) {
+        if (raw.error.isEmpty()) {
+            raw.error = error;
+            if (ffmpegProcess) {
+                ffmpegProcess->kill(); // onProcessFinished reports raw.error
+            }
+        }
+        finishRawExtraction();
+        return;
+    }
+
+    raw.framesWritten++;
+    if (totalFrames > 0 && !dedup.active) { // with duplicates dropped, showinfo reports the position
+        emit progressChanged(qMin(100, raw.framesWritten * 100 / totalFrames));
+    }
+    finishRawExtraction();
+}
+
+void Converter::finishRawExtraction()
+{
+    if (!encodePool || !raw.streamEnded || encodePool->pending() > 0) return;
+    if (raw.error.isEmpty() && raw.backlogOffset < raw.backlog.size()) return; // still draining
+
+    QString error = raw.error;
+    int written = raw.framesWritten;
+    int threads = raw.threads;
+    bool partialFrame = raw.buffer >= 0 && raw.filled > 0;
+    QList<ImageEncodePool::WrittenFrame> frames = encodePool->writtenFrames();
+    bool archived = archiveWriter != nullptr;
+    if (archiveWriter && error.isEmpty()) {
+        archiveWriter->close(error); // every frame is in, so the index is complete
+    }
+    stopRawExtraction();
+    traceSpan("write remaining frames", marks.drain);
+    isProcessing = false;
+
+    if (!error.isEmpty()) {
+        emit finished(false, error);
+        return;
+    }
+    if (partialFrame) {
+        emit logMessage("Warning: the decoded stream ended with an incomplete frame, which was dropped.");
+    }
+    if (dedup.active) {
+        if (dedup.kept.size() != written) {
+            emit logMessage(QString("Warning: FFmpeg reported %1 unique frames but %2 were written.")
+                            .arg(dedup.kept.size()).arg(written));
+        }
+        if (!finishDedup(error)) {
+            emit finished(false, error);
+            return;
+        }
+    }
+
+    if (currentSettings.writeChecksums) {
+        // Hashes of the encoded files, taken by the workers before writing
+        std::sort(frames.begin(), frames.end(), [](const ImageEncodePool::WrittenFrame &a, const ImageEncodePool::WrittenFrame &b) {
+            return a.number < b.number;
+        });
+        QJsonArray frameArray;
+        for (const ImageEncodePool::WrittenFrame &frame : frames) {
+            QJsonObject entry;
+            entry["index"] = frame.number - 1;
+            entry["file"] = frame.file;
+            entry["size"] = frame.size;
+            entry["md5"] = QString::fromLatin1(frame.md5);
+            frameArray.append(entry);
+        }
+        QJsonObject manifest;
+        manifest["output"] = currentSettings.outputPath;
+        manifest["frameAlgorithm"] = "md5";
+        manifest["frames"] = frameArray;
+
+        QString manifestPath = QDir(currentSettings.outputPath).absoluteFilePath("checksums.json");
+        QFile file(manifestPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            emit finished(false, QString("Failed to write checksum manifest: %1").arg(manifestPath));
+            return;
+        }
+        file.write(QJsonDocument(manifest).toJson());
+    }
+
+    emit progressChanged(100);
+    emit finished(true, QString("Extracted %1 frames%2 with %3 encode threads.")
+                        .arg(written).arg(archived ? QString(" into a frame archive") : QString()).arg(threads));
+}
+
+void Converter::stopRawExtraction()
+{
+    if (!encodePool) return;
+    encodePool->disconnect(this);
+    delete encodePool; // waits for in-flight frames
+    encodePool = nullptr;
+    delete archiveWriter;
+    archiveWriter = nullptr;
+    raw = RawExtractState();
+}
+
+void Converter::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    isProcessing = false;
+    if (paused) {
+        // Killed while stopped (cancel)
+        paused = false;
+        pausedMs += pauseClock.elapsed();
+        traceSpan("paused", marks.paused);
+        marks.paused = -1;
+    }
+    traceSpan(marks.step.isEmpty() ? QString("ffmpeg") : marks.step,
+              marks.firstFrame >= 0 ? marks.firstFrame : marks.started,
+              {{"exitCode", exitCode}, {"crashed", exitStatus == QProcess::CrashExit}});
+    
+    if (encodePool && ffmpegProcess) {
+        // Frames ffmpeg wrote just before exiting are still buffered; keep them for the pool
+        raw.backlog = ffmpegProcess->readAllStandardOutput();
+        raw.backlogOffset = 0;
+    }
+    
+    if (ffmpegProcess) {
+        ffmpegProcess->deleteLater();
+        ffmpegProcess = nullptr;
+    }
+    
+    stopFollowing();
+    if (segmentWatcher) {
+        onSegmentDirectoryChanged();
+        stopWatchingSegments();
+    }
+    
+    if (encodePool) {
+        if (exitStatus == QProcess::NormalExit && exitCode == 0 && raw.error.isEmpty()) {
+            // Decoding is done; report success once the pool has written the last frames
+            isProcessing = true;
+            raw.streamEnded = true;
+            if (trace) marks.drain = trace->now();
+            onRawVideoOutput();
+            return;
+        }
+        QString error = raw.error;
+        stopRawExtraction();
+        if (!error.isEmpty()) {
+            emit finished(false, error);
+            return;
+        }
+    }
+    
+    bool moreSteps = exitStatus == QProcess::NormalExit && exitCode == 0 && !pendingSteps.isEmpty();
+    if (!moreSteps) {
+        stopPrefetching();
+    }
+    
+    if (exitStatus == QProcess::CrashExit) {
+        pendingSteps.clear();
+        emit finished(false, "FFmpeg process crashed.");
+        return;
+    }
+    
+    if (exitCode != 0) {
+        pendingSteps.clear();
+        emit finished(false, QString("Conversion failed with exit code %1").arg(exitCode));
+        return;
+    }
+    
+    framesCompleted += currentStepFrames;
+    currentStepFrames = 0;
+    if (!pendingSteps.isEmpty()) {
+        isProcessing = true;
+        startNextStep();
+        return;
+    }
+    
+    if (backgroundFinalizeStep) {
+        // A rename per frame would stall the window on a long extraction
+        auto step = backgroundFinalizeStep;
+        backgroundFinalizeStep = nullptr;
+        isProcessing = true;
+        qint64 moveStart = trace ? trace->now() : -1;
+        finalizeWatcher = new QFutureWatcher<QString>(this);
+        connect(finalizeWatcher, &QFutureWatcher<QString>::finished, this, [this, moveStart]() {
+            // A cancelled future keeps no result; the frames moved so far stay in their shards
+            QString error = finalizeWatcher->isCanceled() ? QString("Conversion cancelled.") : finalizeWatcher->result();
+            finalizeWatcher->deleteLater();
+            finalizeWatcher = nullptr;
+            traceSpan("shard", moveStart);
+            isProcessing = false;
+            if (!error.isEmpty()) {
+                finalizeStep = nullptr;
+                emit finished(false, error);
+                return;
+            }
+            finishConversion();
+        });
+        finalizeWatcher->setFuture(QtConcurrent::run([step](QPromise<QString> &promise) {
+            QString error;
+            bool ok = step(error, [&promise]() { return promise.isCanceled(); });
+            promise.addResult(ok ? QString() : error);
+        }));
+        return;
+    }
+    finishConversion();
+}
+
+void Converter::finishConversion()
+{
+    if (finalizeStep) {
+        QString error;
+        qint64 finalizeStart = trace ? trace->now() : -1;
+        bool ok = finalizeStep(error);
+        finalizeStep = nullptr;
+        traceSpan("finalize", finalizeStart);
+        if (!ok) {
+            emit finished(false, error);
+            return;
+        }
+    }
+    
+    emit progressChanged(100);
+    emit finished(true, "Conversion completed successfully!");
+}
+
+void Converter::onProcessError(QProcess::ProcessError error)
+{
+    // A crash is also delivered through finished(), which reports it
+    if (error == QProcess::Crashed) return;
+    
+    isProcessing = false;
+    pendingSteps.clear();
+    stopFollowing();
+    stopWatchingSegments();
+    
+    QString errorString;
+    switch (error) {
+        case QProcess::FailedToStart:
+            errorString = "Failed to start FFmpeg. Please check if FFmpeg is installed.";
+            break;
+        case QProcess::Timedout:
+            errorString = "FFmpeg process timed out.";
+            break;
+        case QProcess::WriteError:
+            errorString = "Write error occurred.";
+            break;
+        case QProcess::ReadError:
+            errorString = "Read error occurred.";
+            break;
+        default:
+            errorString = "Unknown error occurred.";
+            break;
+    }
+    
+    emit finished(false, errorString);
+}
+
+void Converter::onProcessOutput()
+{
+    if (!ffmpegProcess) return;
+    
+    QByteArray data = ffmpegProcess->readAllStandardError();
+    QString output = dedup.active ? takeDedupOutput(data) : QString::fromUtf8(data);
+    
+    if (!output.isEmpty()) emit logMessage(output);
+    parseProgress(output);
+}
+
+void Converter::parseProgress(const QString &output)
+{
+    // Parse FFmpeg progress output
+    static QRegularExpression frameRegex("frame=\\s*(\\d+)");
     static QRegularExpression timeRegex("time=(\\d{2}):(\\d{2}):(\\d{2}\\.\\d{2})");
     
     QRegularExpressionMatch frameMatch = frameRegex.match(output);
-    if (frameMatch.hasMatch() && totalFrames > 0) {
-        int currentFrame = frameMatch.captured(1).toInt();
+    if (frameMatch.hasMatch() && prefetcher && prefetchBase >= 0) {
+        prefetcher->advanceTo(prefetchBase + frameMatch.captured(1).toInt());
+    }
+    if (frameMatch.hasMatch() && !dedup.active) {
+        emit frameProgress(framesCompleted + frameMatch.captured(1).toInt());
+    }
+    if (frameMatch.hasMatch()) {
+        if (trace && marks.firstFrame < 0 && marks.started >= 0) {
+            traceSpan("first frame", marks.started);
+            marks.firstFrame = trace->now();
+        }
+    }
+    if (frameMatch.hasMatch() && totalFrames > 0 && !dedup.active) {
+        int currentFrame = framesCompleted + frameMatch.captured(1).toInt();
         int percentage = qMin(100, (currentFrame * 100) / totalFrames);
         emit progressChanged(percentage);
     }
@@ -9,6 +9,11 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QThread>
+#include <QFileSystemWatcher>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QFutureWatcher>
+#include <functional>
 
 struct ConversionSettings {
     QString inputPath;
@@ -27,46 +32,267 @@ struct ConversionSettings {
     int endFrame;
     bool extractAllFrames;
     QString customCommand; // optional raw ffmpeg command
+
+    // Incremental re-encode: encode closed-GOP segments and only redo changed ones
+    bool incremental = false;
+    int segmentLength = 240; // frames per segment
+
+    // Streaming output: "None", "Fragmented MP4", "HLS" or "DASH"
+    QString streamingMode = "None";
+    int segmentDuration = 4; // seconds per streaming segment
+
+    // Follow mode: encode frames as a renderer writes them, piped through stdin
+    bool followSequence = false;
+    int followTimeout = 120; // seconds without a new frame that mark the end of the sequence
+
+    // Write per-frame and whole-stream checksums during the encode (tee muxer)
+    bool writeChecksums = false;
+
+    // x264/x265 speed preset; empty leaves the encoder default
+    QString encoderPreset;
+    // Pick preset and CRF from trial encodes of a few samples before converting
+    bool autoTune = false;
+    double targetSsim = 0.98;
+
+    // Encoder speed tier: "Draft", "Balanced" or "Archive"
+    QString speedTier = "Balanced";
+
+    // ffmpeg pixel format for the encode; empty uses the codec's default
+    QString pixelFormat;
+
+    // Video to sequence: ffmpeg only decodes to rawvideo and a thread pool encodes the images
+    bool parallelImageEncode = false;
+    int encodeThreads = 0;     // 0 uses one per core
+    int compressionLevel = -1; // 0 (fastest) to 9 (smallest); -1 keeps the writer default
+
+    // Video to sequence: "All", "Keyframes", "Every Nth" or "Evenly Spaced" frames of the range
+    QString samplingMode = "All";
+    int sampleInterval = 10; // Every Nth: keep one frame in this many
+    int sampleCount = 100;   // Evenly Spaced: frames to extract
+
+    // Video to sequence: write frames into indexed pack files instead of one file per frame
+    bool frameArchive = false;
+
+    // Video to sequence file names: template ending in {frame} ({name} is the input's base name),
+    // digits in the frame number (0 sizes it to the frame count) and frames per subdirectory (0 for none)
+    QString nameTemplate = "frame_{frame}";
+    int framePadding = 0;
+    int shardSize = 0;
+
+    // Video to sequence: keep only frames that differ from the one before (mpdecimate) and record
+    // which source frames each stored frame stands for in dedup.json
+    bool dedupFrames = false;
+    // Sequence to video: repeat frames as a dedup.json in the input directory says, restoring the original length
+    bool expandDuplicates = true;
+
+    // Sequence to sequence: "Source", "8-bit" or "16-bit" per channel (EXR is always float)
+    QString bitDepth = "Source";
+
+    // Frames read ahead of the encoder to hide network storage latency; 0 disables
+    int prefetchDepth = 0;
+
+    // Input frames already found by the caller (e.g. on a worker thread); not persisted
+    QStringList imageFiles;
+    // ffmpeg thread budget handed out by the job queue; 0 lets ffmpeg decide; not persisted
+    int threads = 0;
 };
 
+class EncoderTuner;
+class SequenceTranscoder;
+class ImageEncodePool;
+struct VideoInfo;
+struct ProbeResult;
+class TraceRecorder;
+class FramePrefetcher;
+class FrameArchiveWriter;
+class FrameNaming;
+
 class Converter : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit Converter(QObject *parent = nullptr);
+    // lookUpFFmpeg false leaves the path empty until setFFmpegPath, for callers that search in the background
+    explicit Converter(QObject *parent = nullptr, bool lookUpFFmpeg = true);
     ~Converter();
     
     void convertSequenceToVideo(const ConversionSettings &settings);
     void convertVideoToSequence(const ConversionSettings &settings);
+    // Rewraps a video into settings.videoFormat, stream-copying when the codec fits the container
+    void convertVideoToVideo(const ConversionSettings &settings);
+    // Rewrites every frame of a sequence as settings.imageFormat in settings.outputPath, in parallel
+    void convertSequenceToSequence(const ConversionSettings &settings);
     void cancel();
+    // Suspend/continue the running ffmpeg (SIGSTOP/SIGCONT); false where unsupported or idle
+    bool pause();
+    bool resume();
+    bool isPaused() const;
+    qint64 pausedMilliseconds() const; // time spent paused during the current job
+    qint64 processId() const;          // running ffmpeg, 0 if none
+    // Records spawn, first-frame, encode, finalize and pause spans on the given track
+    void setTrace(TraceRecorder *recorder, int track);
     
     bool isFFmpegAvailable();
 
     QStringList buildFFmpegArguments(const ConversionSettings &settings, bool isSequenceToVideo);
-    QString findFFmpegPath() const;
+    QStringList buildSequenceInputArguments(const QStringList &imageFiles, int first, int count, int frameRate) const;
+    QStringList buildVideoEncodeArguments(const ConversionSettings &settings);
+    QStringList buildRemuxArguments(const ConversionSettings &settings, const VideoInfo &source);
+    static QString findFFmpegPath();
+    void setFFmpegPath(const QString &path);
+    static QString outputExtension(const ConversionSettings &settings);
+    static QString validateSettings(const ConversionSettings &settings);
+    static QStringList findImageFiles(const QString &directory, const std::function<bool()> &isCanceled = nullptr);
+    static QStringList imageExtensions();
+    static bool parseFrameNumber(const QString &baseName, QString &prefix, int &number, int &padding);
+    static bool canStreamCopy(const QString &sourceCodec, const QString &container);
+    static bool canPassThroughJpeg(const ConversionSettings &settings, const QStringList &imageFiles);
 
 signals:
     void progressChanged(int percentage);
+    void frameProgress(int frames); // input frames done across all steps, from ffmpeg's status line
     void finished(bool success, const QString &message);
     void logMessage(const QString &message);
+    void segmentsAvailable(int count, const QString &playlistPath);
+    void encoderTuned(const QString &preset, int quality);
 
 private slots:
     void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onProcessError(QProcess::ProcessError error);
     void onProcessOutput();
+    void onSegmentDirectoryChanged();
+    void onFollowTick();
+    void onRawVideoOutput();
+    void onEncodeBufferReleased();
+    void onRawFrameWritten(int frameNumber, bool success, const QString &error);
 
 private:
+    struct ConversionStep {
+        QStringList arguments;
+        QString description;
+        int frames; // input frames covered, used for overall progress
+        int firstFrame = -1; // index of the step's first input frame, -1 if it reads no frames
+    };
+
     QString getVideoCodecName(const QString &codec);
-    QString getVideoFormatExtension(const QString &format);
-    QStringList findImageFiles(const QString &directory);
+    static QString muxerName(const QString &format);
     void parseProgress(const QString &output);
+    bool prepareIncrementalEncode(const QStringList &imageFiles, QString &error);
+    void startProcess(const QStringList &args);
+    void startNextStep();
+    QStringList speedTierArguments(const QString &codecName, const ConversionSettings &settings) const;
+    QStringList buildStreamingArguments(const ConversionSettings &settings) const;
+    void watchStreamingSegments();
+    void stopWatchingSegments();
+    QStringList buildPipeInputArguments(const ConversionSettings &settings, const QString &extension) const;
+    QStringList buildChecksumOutputArguments(const QString &format, const QString &output, const QString &sidecarBase) const;
+    void addChecksumFinalizeStep(const QString &sidecarBase, const QString &manifestPath,
+                                 const std::function<QString(int)> &frameName);
+    void addShardFinalizeStep(const FrameNaming &naming);
+    void finishConversion();
+    void startFollowing();
+    void stopFollowing();
+    QString followFramePath(int number) const;
+    // Runs ffprobe on a worker thread and continues with next here; cancel() drops the result
+    void probeInput(const QString &videoPath, bool withKeyframes, const std::function<void(const ProbeResult &)> &next);
+    void startVideoExtraction(const ConversionSettings &settings, const ProbeResult &probe);
+    bool startRawExtraction(const ConversionSettings &settings, const ProbeResult &probe, QString &error);
+    bool prepareSampledExtraction(const ConversionSettings &settings, const ProbeResult &probe, QString &error);
+    QStringList dedupFilterArguments(const ConversionSettings &settings) const;
+    static QString rangeFilter(const ConversionSettings &settings);
+    void beginDedup(const ConversionSettings &settings, const VideoInfo &info, const FrameNaming &naming);
+    QString takeDedupOutput(const QByteArray &data);
+    bool finishDedup(QString &error);
+    static bool expandsDuplicates(const ConversionSettings &settings);
+    qint64 readRawVideo(char *data, qint64 maxSize);
+    void finishRawExtraction();
+    void stopRawExtraction();
+    void applyStopState();
+    void traceSpan(const QString &name, qint64 startUs, const QJsonObject &args = QJsonObject());
+    void startPrefetching(const QStringList &imageFiles);
+    void stopPrefetching();
     
     QProcess *ffmpegProcess;
     ConversionSettings currentSettings;
     bool isProcessing;
     int totalFrames;
+    int framesCompleted; // frames finished by earlier steps of a multi-step job
+    int currentStepFrames;
+    QList<ConversionStep> pendingSteps;
+    std::function<bool(QString &error)> finalizeStep; // runs after the last step succeeds
+    // File moves that touch every frame (sharding); run on a worker before finalizeStep
+    std::function<bool(QString &error, const std::function<bool()> &isCanceled)> backgroundFinalizeStep;
+    QFutureWatcher<QString> *finalizeWatcher; // cancelled by cancel(); reports once the worker has stopped
+    QFileSystemWatcher *segmentWatcher;
+    int segmentsReported;
+
+    struct FollowState {
+        bool started = false;
+        QDir directory;
+        QString prefix;
+        QString extension;
+        int padding = 0;
+        int nextNumber = 0;
+        qint64 candidateSize = -1; // size seen on the previous poll, for the stability check
+        int framesStreamed = 0;
+        QElapsedTimer idleTimer;
+    };
+    QTimer *followTimer;
+    FollowState follow;
+    EncoderTuner *tuner;
+    SequenceTranscoder *transcoder;
+
+    struct RawExtractState {
+        int buffer = -1;           // pool buffer being filled from stdout
+        qint64 filled = 0;
+        int nextFrame = 1;         // image2 numbers files from 1
+        int framesWritten = 0;
+        int threads = 0;
+        bool throttled = false;    // ffmpeg stopped until the pool frees buffers
+        bool streamEnded = false;  // ffmpeg exited; draining what it left behind
+        QByteArray backlog;        // stdout still unread when ffmpeg exited
+        qint64 backlogOffset = 0;
+        QString error;
+    };
+    FramePrefetcher *prefetcher;
+    int prefetchBase; // input frame index the running step started at, -1 when not reading frames
+    ImageEncodePool *encodePool;
+    FrameArchiveWriter *archiveWriter; // set while a raw extraction writes a frame archive
+    QFutureWatcher<ProbeResult> *probeWatcher; // set while the input is being probed
+    RawExtractState raw;
+
+    // Duplicate elimination: showinfo reports each frame mpdecimate lets through
+    struct DedupState {
+        bool active = false;
+        double frameRate = 0.0;
+        int firstFrame = 0;     // source frame the extraction starts at
+        int originalFrames = 0; // source frames the extraction covers
+        QList<int> kept;        // source frame of each stored frame, in order
+        QByteArray pending;     // stderr after the last complete line
+        std::function<QString(int)> frameName;
+    };
+    DedupState dedup;
+
+    bool paused;
+    bool processStopped; // SIGSTOP currently in effect, for the user or for back-pressure
+    QElapsedTimer pauseClock;
+    qint64 pausedMs;
     QString ffmpegPath;
+
+    // Start times (trace microseconds, -1 if unset) of the spans in progress
+    struct TraceMarks {
+        qint64 conversion = -1;
+        qint64 tuning = -1;
+        qint64 spawn = -1;
+        qint64 started = -1;
+        qint64 firstFrame = -1;
+        qint64 drain = -1;
+        qint64 paused = -1;
+        QString step; // name of the ffmpeg run, e.g. "encode" or a segment description
+    };
+    TraceRecorder *trace;
+    int traceTrack;
+    TraceMarks marks;
 };
 
 #endif // CONVERTER_H
\ No newline at end of file
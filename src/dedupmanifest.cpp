@@ -0,0 +1,112 @@
+// dedupmanifest.cpp
+#include "dedupmanifest.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QCryptographicHash>
+
+bool DedupManifest::exists(const QString &directory)
+{
+    return QFileInfo::exists(QDir(directory).absoluteFilePath(FileName));
+}
+
+bool DedupManifest::write(const QString &directory, const QString &source, double frameRate, int firstFrame,
+                          int originalFrames, const QList<int> &keptFrames,
+                          const std::function<QString(int)> &frameName, QString &error)
+{
+    QString path = QDir(directory).absoluteFilePath(FileName);
+    if (keptFrames.isEmpty()) {
+        error = "No frames were kept, so there is nothing to record in the duplicate-frame manifest.";
+        return false;
+    }
+
+    // A stored frame runs until the next one; the last runs to the end of the extraction
+    int end = firstFrame + originalFrames;
+    QJsonArray stored;
+    for (int i = 0; i < keptFrames.size(); ++i) {
+        int next = i + 1 < keptFrames.size() ? keptFrames.at(i + 1) : end;
+        stored.append(QJsonObject{{"file", frameName(i + 1)},
+                                  {"first", keptFrames.at(i)},
+                                  {"count", qMax(1, next - keptFrames.at(i))}});
+    }
+    QJsonObject manifest{{"source", source}, {"frameRate", frameRate}, {"firstFrame", firstFrame},
+                         {"originalFrames", originalFrames}, {"stored", stored}};
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(manifest).toJson()) < 0 || !file.commit()) {
+        error = QString("Failed to write duplicate-frame manifest: %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool DedupManifest::read(const QString &directory, QList<Entry> &entries, int &originalFrames, QString &error)
+{
+    QString path = QDir(directory).absoluteFilePath(FileName);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("Cannot read duplicate-frame manifest: %1").arg(path);
+        return false;
+    }
+    QJsonObject manifest = QJsonDocument::fromJson(file.readAll()).object();
+    entries.clear();
+    originalFrames = 0;
+    for (const QJsonValue &value : manifest["stored"].toArray()) {
+        QJsonObject object = value.toObject();
+        Entry entry;
+        entry.file = object["file"].toString();
+        entry.first = object["first"].toInt();
+        entry.count = qMax(1, object["count"].toInt(1));
+        if (entry.file.isEmpty()) continue;
+        entries.append(entry);
+        originalFrames += entry.count;
+    }
+    if (entries.isEmpty()) {
+        error = QString("Duplicate-frame manifest lists no frames: %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+QString DedupManifest::concatListPath(const QString &directory)
+{
+    // One list per input directory, so rebuilding the arguments names the same file
+    QByteArray key = QCryptographicHash::hash(QDir(directory).absolutePath().toUtf8(), QCryptographicHash::Md5).toHex();
+    return QDir::temp().absoluteFilePath(QString("isc-expand-%1.ffconcat").arg(QString::fromLatin1(key.left(12))));
+}
+
+bool DedupManifest::writeConcatList(const QString &directory, int frameRate, int &originalFrames, QString &error)
+{
+    QList<Entry> entries;
+    if (!read(directory, entries, originalFrames, error)) return false;
+
+    QDir root(directory);
+    auto quoted = [&root](const QString &file) {
+        QString path = root.absoluteFilePath(file);
+        return QString("file '%1'\n").arg(path.replace("'", "'\\''"));
+    };
+    double fps = qMax(1, frameRate);
+    QByteArray list = "ffconcat version 1.0\n";
+    for (const Entry &entry : entries) {
+        if (!root.exists(entry.file)) {
+            error = QString("Frame %1 listed in the duplicate-frame manifest is missing.").arg(entry.file);
+            return false;
+        }
+        list += quoted(entry.file).toUtf8();
+        list += QString("duration %1\n").arg(entry.count / fps, 0, 'f', 6).toUtf8();
+    }
+    // The concat demuxer ignores the last duration unless the file is listed again
+    list += quoted(entries.last().file).toUtf8();
+
+    QString path = concatListPath(directory);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(list) < 0 || !file.commit()) {
+        error = QString("Failed to write frame list: %1").arg(path);
+        return false;
+    }
+    return true;
+}
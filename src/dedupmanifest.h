@@ -0,0 +1,39 @@
+// dedupmanifest.h
+#ifndef DEDUPMANIFEST_H
+#define DEDUPMANIFEST_H
+
+#include <QString>
+#include <QList>
+#include <functional>
+
+// Remap manifest of an extraction that dropped duplicate frames. Each stored
+// frame stands for itself and the run of identical source frames after it, so
+// dedup.json lists, per stored file, the first source frame it covers and how
+// many it covers. Expanding the runs gives back the original numbering, which
+// is how a deduplicated directory is turned back into a full-length video.
+class DedupManifest
+{
+public:
+    static constexpr const char *FileName = "dedup.json";
+
+    struct Entry {
+        QString file; // relative to the directory
+        int first = 0; // source frame number
+        int count = 1; // source frames it stands for
+    };
+
+    static bool exists(const QString &directory);
+
+    // keptFrames: source frame of each stored frame in storage order, within
+    // [firstFrame, firstFrame + originalFrames); frameName maps storage numbers (from 1) to files
+    static bool write(const QString &directory, const QString &source, double frameRate, int firstFrame,
+                      int originalFrames, const QList<int> &keptFrames,
+                      const std::function<QString(int)> &frameName, QString &error);
+    static bool read(const QString &directory, QList<Entry> &entries, int &originalFrames, QString &error);
+
+    // ffconcat list that shows every stored frame for its whole run at frameRate
+    static QString concatListPath(const QString &directory);
+    static bool writeConcatList(const QString &directory, int frameRate, int &originalFrames, QString &error);
+};
+
+#endif // DEDUPMANIFEST_H
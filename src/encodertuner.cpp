@@ -0,0 +1,223 @@
+// encodertuner.cpp
+#include "encodertuner.h"
+#include <QThread>
+#include <QRegularExpression>
+#include <QDir>
+#include <QFile>
+
+EncoderTuner::EncoderTuner(Converter *converter, const QString &ffmpegPath, QObject *parent)
+    : QObject(parent)
+    , converter(converter)
+    , ffmpegPath(ffmpegPath)
+    , maxParallel(qMax(1, QThread::idealThreadCount()))
+    , cancelled(false)
+{
+}
+
+EncoderTuner::~EncoderTuner()
+{
+    // Don't report back to the owner while it is tearing us down
+    const QList<QProcess *> processes = running.keys();
+    for (QProcess *process : processes) {
+        disconnect(process, nullptr, this, nullptr);
+        process->kill();
+        process->waitForFinished(1000);
+    }
+}
+
+void EncoderTuner::tune(const ConversionSettings &tuneSettings, const QStringList &files)
+{
+    settings = tuneSettings;
+    imageFiles = files;
+    cancelled = false;
+    samples.clear();
+    candidates.clear();
+    queue.clear();
+
+    if (!workDir.isValid()) {
+        emit finished(false, QString(), settings.quality);
+        return;
+    }
+
+    // Three short windows spread across the shot so a quiet opening doesn't decide for the busy middle
+    const int sampleFrames = qMin(24, static_cast<int>(imageFiles.size()));
+    for (double position : {0.1, 0.5, 0.9}) {
+        int first = qBound(0, static_cast<int>(position * imageFiles.size()) - sampleFrames / 2,
+                           static_cast<int>(imageFiles.size()) - sampleFrames);
+        if (samples.isEmpty() || samples.last().first != first) {
+            samples.append({first, sampleFrames});
+        }
+    }
+
+    const QStringList presets = {"veryfast", "faster", "fast", "medium", "slow"};
+    for (const QString &preset : presets) {
+        for (int offset : {-4, 0, 4}) {
+            Candidate candidate;
+            candidate.preset = preset;
+            candidate.quality = qBound(1, settings.quality + offset, 51);
+            candidates.append(candidate);
+        }
+    }
+
+    emit logMessage(QString("Auto-tuning: %1 candidates x %2 samples, target SSIM %3...")
+                    .arg(candidates.size()).arg(samples.size()).arg(settings.targetSsim));
+    clock.start();
+    startTrials();
+}
+
+void EncoderTuner::cancel()
+{
+    cancelled = true;
+    queue.clear();
+    const QList<QProcess *> processes = running.keys();
+    for (QProcess *process : processes) {
+        process->kill();
+        process->waitForFinished(1000);
+    }
+}
+
+QString EncoderTuner::scaleFilter() const
+{
+    if (settings.maintainAspectRatio) {
+        return QString("scale=%1:%2:force_original_aspect_ratio=decrease,pad=%1:%2:(ow-iw)/2:(oh-ih)/2")
+               .arg(settings.width).arg(settings.height);
+    }
+    return QString("scale=%1:%2").arg(settings.width).arg(settings.height);
+}
+
+void EncoderTuner::startTrials()
+{
+    for (int c = 0; c < candidates.size(); ++c) {
+        ConversionSettings trialSettings = settings;
+        trialSettings.encoderPreset = candidates.at(c).preset;
+        trialSettings.quality = candidates.at(c).quality;
+        QStringList encodeArgs = converter->buildVideoEncodeArguments(trialSettings);
+
+        for (int s = 0; s < samples.size(); ++s) {
+            Trial trial;
+            trial.candidate = c;
+            trial.sample = s;
+            trial.scoring = false;
+            trial.output = workDir.filePath(QString("trial_%1_%2.mkv").arg(c).arg(s));
+            trial.arguments << converter->buildSequenceInputArguments(imageFiles, samples.at(s).first, samples.at(s).second,
+                                                                      settings.frameRate);
+            trial.arguments << encodeArgs;
+            // One thread per trial keeps timings comparable while trials share the machine
+            trial.arguments << "-threads" << "1";
+            trial.arguments << "-an" << "-f" << "matroska" << "-y" << trial.output;
+            queue.append(trial);
+        }
+    }
+
+    while (running.size() < maxParallel && !queue.isEmpty()) {
+        launch(queue.takeFirst());
+    }
+}
+
+void EncoderTuner::launch(const Trial &trial)
+{
+    QProcess *process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::SeparateChannels);
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &EncoderTuner::onTrialFinished);
+    running.insert(process, trial);
+    startedAt.insert(process, clock.elapsed());
+    process->start(ffmpegPath, trial.arguments);
+}
+
+void EncoderTuner::onTrialFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (!process || !running.contains(process)) return;
+
+    Trial trial = running.take(process);
+    qint64 elapsed = clock.elapsed() - startedAt.take(process);
+    QString output = QString::fromUtf8(process->readAllStandardError());
+    process->deleteLater();
+
+    if (cancelled) {
+        if (running.isEmpty()) emit finished(false, QString(), settings.quality);
+        return;
+    }
+
+    Candidate &candidate = candidates[trial.candidate];
+    if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+        candidate.failed = true;
+    } else if (!trial.scoring) {
+        candidate.encodeMs += elapsed;
+
+        // Score against the source run through the same scaling as the encode
+        Trial score;
+        score.candidate = trial.candidate;
+        score.sample = trial.sample;
+        score.scoring = true;
+        score.arguments << "-i" << trial.output;
+        score.arguments << converter->buildSequenceInputArguments(imageFiles, samples.at(trial.sample).first,
+                                                                  samples.at(trial.sample).second, settings.frameRate);
+        score.arguments << "-lavfi" << QString("[0:v]format=yuv420p[dist];[1:v]%1,format=yuv420p[ref];[dist][ref]ssim")
+                                       .arg(scaleFilter());
+        score.arguments << "-f" << "null" << "-";
+        // Scores jump the queue so trial files can be deleted early
+        queue.prepend(score);
+    } else {
+        static QRegularExpression ssimRegex("All:([0-9.]+)");
+        QRegularExpressionMatch match = ssimRegex.match(output);
+        if (match.hasMatch()) {
+            candidate.ssimSum += match.captured(1).toDouble();
+            candidate.scored++;
+        } else {
+            candidate.failed = true;
+        }
+        QFile::remove(workDir.filePath(QString("trial_%1_%2.mkv").arg(trial.candidate).arg(trial.sample)));
+    }
+
+    while (running.size() < maxParallel && !queue.isEmpty()) {
+        launch(queue.takeFirst());
+    }
+
+    if (running.isEmpty() && queue.isEmpty()) {
+        pickWinner();
+    }
+}
+
+void EncoderTuner::pickWinner()
+{
+    int best = -1;
+    int bestQuality = -1;
+    double bestQualityScore = -1.0;
+
+    for (int i = 0; i < candidates.size(); ++i) {
+        const Candidate &candidate = candidates.at(i);
+        if (candidate.failed || candidate.scored == 0) continue;
+
+        double ssim = candidate.ssimSum / candidate.scored;
+        emit logMessage(QString("  %1 CRF %2: %3 ms, SSIM %4")
+                        .arg(candidate.preset).arg(candidate.quality)
+                        .arg(candidate.encodeMs).arg(ssim, 0, 'f', 5));
+
+        if (ssim > bestQualityScore) {
+            bestQualityScore = ssim;
+            bestQuality = i;
+        }
+        if (ssim >= settings.targetSsim
+            && (best < 0 || candidate.encodeMs < candidates.at(best).encodeMs)) {
+            best = i;
+        }
+    }
+
+    if (best < 0 && bestQuality < 0) {
+        emit logMessage("Auto-tuning failed: no trial encode could be scored.");
+        emit finished(false, QString(), settings.quality);
+        return;
+    }
+
+    if (best < 0) {
+        emit logMessage(QString("No candidate reached SSIM %1, using the highest-quality one.").arg(settings.targetSsim));
+        best = bestQuality;
+    }
+
+    const Candidate &winner = candidates.at(best);
+    emit logMessage(QString("Auto-tune picked preset %1, CRF %2 in %3 s.")
+                    .arg(winner.preset).arg(winner.quality).arg(clock.elapsed() / 1000.0, 0, 'f', 1));
+    emit finished(true, winner.preset, winner.quality);
+}
@@ -0,0 +1,72 @@
+// encodertuner.h
+#ifndef ENCODERTUNER_H
+#define ENCODERTUNER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QList>
+#include <QHash>
+#include "converter.h"
+
+// Picks the fastest x264/x265 preset and CRF that reach a target SSIM by
+// encoding a few short samples of the sequence in parallel and scoring them
+// locally with ffmpeg's ssim filter.
+class EncoderTuner : public QObject
+{
+    Q_OBJECT
+
+public:
+    EncoderTuner(Converter *converter, const QString &ffmpegPath, QObject *parent = nullptr);
+    ~EncoderTuner();
+
+    void tune(const ConversionSettings &settings, const QStringList &imageFiles);
+    void cancel();
+
+signals:
+    void logMessage(const QString &message);
+    void finished(bool success, const QString &preset, int quality);
+
+private slots:
+    void onTrialFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    struct Candidate {
+        QString preset;
+        int quality;
+        qint64 encodeMs = 0;
+        double ssimSum = 0.0;
+        int scored = 0;
+        bool failed = false;
+    };
+
+    struct Trial {
+        int candidate;
+        int sample;
+        bool scoring; // false = encode pass, true = ssim pass
+        QStringList arguments;
+        QString output;
+    };
+
+    void startTrials();
+    void launch(const Trial &trial);
+    void pickWinner();
+    QString scaleFilter() const;
+
+    Converter *converter;
+    QString ffmpegPath;
+    ConversionSettings settings;
+    QStringList imageFiles;
+    QList<QPair<int, int>> samples; // first frame index, frame count
+    QList<Candidate> candidates;
+    QList<Trial> queue;
+    QHash<QProcess *, Trial> running;
+    QHash<QProcess *, qint64> startedAt;
+    QElapsedTimer clock;
+    QTemporaryDir workDir;
+    int maxParallel;
+    bool cancelled;
+};
+
+#endif // ENCODERTUNER_H
@@ -0,0 +1,247 @@
+// framearchive.cpp
+#include "framearchive.h"
+#include <QFileInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char Magic[8] = {'I', 'S', 'C', 'F', 'R', 'A', 'M', 'E'};
+const quint32 Version = 1;
+const int HeaderSize = 16;
+const int EntrySize = 24;
+
+// Packs roll over here; large enough that a long extraction is a handful of files
+const qint64 PackLimit = qint64(4) * 1024 * 1024 * 1024;
+
+} // namespace
+
+QString FrameArchive::packName(int pack)
+{
+    return QString("frames-%1.pack").arg(pack, 3, 10, QChar('0'));
+}
+
+bool FrameArchive::isArchive(const QString &directory)
+{
+    return QFileInfo::exists(QDir(directory).absoluteFilePath(IndexName));
+}
+
+FrameArchiveWriter::FrameArchiveWriter()
+    : packNumber(-1)
+    , packSize(0)
+{
+}
+
+FrameArchiveWriter::~FrameArchiveWriter()
+{
+    QString ignored;
+    close(ignored);
+}
+
+bool FrameArchiveWriter::open(const QString &path, const QByteArray &format, QString &error)
+{
+    directory = QDir(path);
+    if (!directory.mkpath(".")) {
+        error = QString("Failed to create output directory: %1").arg(path);
+        return false;
+    }
+    // A new extraction replaces an old archive rather than appending to it
+    for (const QString &old : directory.entryList({"frames-*.pack"}, QDir::Files)) {
+        directory.remove(old);
+    }
+
+    index.setFileName(directory.absoluteFilePath(FrameArchive::IndexName));
+    if (!index.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        error = QString("Failed to create %1: %2").arg(index.fileName(), index.errorString());
+        return false;
+    }
+    char header[HeaderSize] = {};
+    memcpy(header, Magic, sizeof(Magic));
+    qToLittleEndian<quint32>(Version, header + 8);
+    memcpy(header + 12, format.constData(), qMin<qsizetype>(format.size(), 4));
+    if (index.write(header, HeaderSize) != HeaderSize) {
+        error = QString("Failed to write %1: %2").arg(index.fileName(), index.errorString());
+        return false;
+    }
+
+    packNumber = -1;
+    return startPack(error);
+}
+
+bool FrameArchiveWriter::startPack(QString &error)
+{
+    if (pack) pack->close();
+    ++packNumber;
+    packSize = 0;
+    pack = std::make_unique<QFile>(directory.absoluteFilePath(FrameArchive::packName(packNumber)));
+    if (!pack->open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        error = QString("Failed to create %1: %2").arg(pack->fileName(), pack->errorString());
+        return false;
+    }
+    return true;
+}
+
+bool FrameArchiveWriter::append(int frameNumber, const QByteArray &data, QString &error)
+{
+    QMutexLocker lock(&mutex);
+    if (!pack || !index.isOpen()) {
+        error = "The frame archive is not open.";
+        return false;
+    }
+    if (packSize > 0 && packSize + data.size() > PackLimit && !startPack(error)) return false;
+
+    if (pack->write(data) != data.size()) {
+        error = QString("Failed to write %1: %2").arg(pack->fileName(), pack->errorString());
+        return false;
+    }
+
+    char entry[EntrySize];
+    qToLittleEndian<quint32>(quint32(frameNumber), entry);
+    qToLittleEndian<quint32>(quint32(packNumber), entry + 4);
+    qToLittleEndian<quint64>(quint64(packSize), entry + 8);
+    qToLittleEndian<quint64>(quint64(data.size()), entry + 16);
+    packSize += data.size();
+    if (index.write(entry, EntrySize) != EntrySize) {
+        error = QString("Failed to write %1: %2").arg(index.fileName(), index.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool FrameArchiveWriter::close(QString &error)
+{
+    QMutexLocker lock(&mutex);
+    bool ok = true;
+    if (pack && !pack->flush()) {
+        error = QString("Failed to write %1: %2").arg(pack->fileName(), pack->errorString());
+        ok = false;
+    }
+    pack.reset();
+    // The index goes last so it never names data that is not on disk
+    if (index.isOpen() && !index.flush()) {
+        error = QString("Failed to write %1: %2").arg(index.fileName(), index.errorString());
+        ok = false;
+    }
+    index.close();
+    return ok;
+}
+
+bool FrameArchiveReader::open(const QString &path, QString &error)
+{
+    close();
+    QDir directory(path);
+    QFile index(directory.absoluteFilePath(FrameArchive::IndexName));
+    if (!index.open(QIODevice::ReadOnly)) {
+        error = QString("Cannot open %1: %2").arg(index.fileName(), index.errorString());
+        return false;
+    }
+    QByteArray bytes = index.readAll();
+    if (bytes.size() < HeaderSize || memcmp(bytes.constData(), Magic, sizeof(Magic)) != 0
+        || qFromLittleEndian<quint32>(bytes.constData() + 8) != Version) {
+        error = QString("%1 is not a frame archive index.").arg(index.fileName());
+        return false;
+    }
+    imageFormat = QByteArray(bytes.constData() + 12, 4);
+    imageFormat.truncate(qstrnlen(imageFormat.constData(), 4));
+
+    // A trailing partial record is what an interrupted write leaves; it is ignored
+    quint32 packCount = 0;
+    const char *record = bytes.constData() + HeaderSize;
+    qsizetype records = (bytes.size() - HeaderSize) / EntrySize;
+    entries.reserve(records);
+    for (qsizetype i = 0; i < records; ++i, record += EntrySize) {
+        Entry entry;
+        int frame = int(qFromLittleEndian<quint32>(record));
+        entry.pack = qFromLittleEndian<quint32>(record + 4);
+        entry.offset = qFromLittleEndian<quint64>(record + 8);
+        entry.size = qFromLittleEndian<quint64>(record + 16);
+        entries.insert(frame, entry);
+        packCount = qMax(packCount, entry.pack + 1);
+    }
+    numbers = entries.keys();
+    std::sort(numbers.begin(), numbers.end());
+
+    for (quint32 i = 0; i < packCount; ++i) {
+        auto pack = std::make_unique<QFile>(directory.absoluteFilePath(FrameArchive::packName(int(i))));
+        if (!pack->open(QIODevice::ReadOnly)) {
+            error = QString("Cannot open %1: %2").arg(pack->fileName(), pack->errorString());
+            close();
+            return false;
+        }
+        packs.push_back(std::move(pack));
+    }
+    return true;
+}
+
+void FrameArchiveReader::close()
+{
+    entries.clear();
+    numbers.clear();
+    imageFormat.clear();
+    packs.clear();
+}
+
+bool FrameArchiveReader::readFrame(int frameNumber, QByteArray &data, QString &error) const
+{
+    auto it = entries.constFind(frameNumber);
+    if (it == entries.cend()) {
+        error = QString("Frame %1 is not in the archive.").arg(frameNumber);
+        return false;
+    }
+    QFile *pack = packs.at(it->pack).get();
+    data.resize(qsizetype(it->size));
+
+#ifdef Q_OS_UNIX
+    qint64 done = 0;
+    while (done < qint64(it->size)) {
+        ssize_t got = ::pread(pack->handle(), data.data() + done, size_t(it->size - done), off_t(it->offset + done));
+        if (got <= 0) break;
+        done += got;
+    }
+    bool ok = done == qint64(it->size);
+#else
+    QMutexLocker lock(&seekMutex);
+    bool ok = pack->seek(qint64(it->offset)) && pack->read(data.data(), qint64(it->size)) == qint64(it->size);
+#endif
+    if (!ok) {
+        error = QString("Short read of frame %1 from %2").arg(frameNumber).arg(pack->fileName());
+        data.clear();
+    }
+    return ok;
+}
+
+bool FrameArchiveMappedReader::open(const QString &path, QString &error)
+{
+    close();
+    if (!FrameArchiveReader::open(path, error)) return false;
+    for (const auto &pack : packs) {
+        // Mapping an empty file fails; it holds no frames anyway
+        const uchar *map = pack->size() > 0 ? pack->map(0, pack->size()) : nullptr;
+        if (pack->size() > 0 && !map) {
+            error = QString("Cannot map %1: %2").arg(pack->fileName(), pack->errorString());
+            close();
+            return false;
+        }
+        maps.push_back(map);
+    }
+    return true;
+}
+
+void FrameArchiveMappedReader::close()
+{
+    maps.clear(); // the QFiles unmap when the base class drops them
+    FrameArchiveReader::close();
+}
+
+QByteArray FrameArchiveMappedReader::frame(int frameNumber) const
+{
+    auto it = entries.constFind(frameNumber);
+    if (it == entries.cend() || it->pack >= maps.size() || !maps.at(it->pack)) return QByteArray();
+    if (it->offset + it->size > quint64(packs.at(it->pack)->size())) return QByteArray();
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(maps.at(it->pack) + it->offset), qsizetype(it->size));
+}
@@ -0,0 +1,93 @@
+// framearchive.h
+#ifndef FRAMEARCHIVE_H
+#define FRAMEARCHIVE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <memory>
+#include <vector>
+
+// A directory of large append-only pack files (frames-000.pack, ...) holding
+// encoded images back to back, plus frames.idx: a 16-byte header ("ISCFRAME",
+// version, image format) followed by one 24-byte little-endian record per
+// frame (frame number, pack, offset, size). The index is appended after each
+// frame's data (both unbuffered), so an interrupted extraction still leaves
+// a readable prefix.
+// Any frame is one positioned read, without a per-frame open/stat/close.
+namespace FrameArchive {
+    const char *const IndexName = "frames.idx";
+    QString packName(int pack);
+    bool isArchive(const QString &directory);
+}
+
+class FrameArchiveWriter
+{
+public:
+    FrameArchiveWriter();
+    ~FrameArchiveWriter();
+
+    bool open(const QString &directory, const QByteArray &format, QString &error);
+    // Thread-safe; frames may arrive in any order
+    bool append(int frameNumber, const QByteArray &data, QString &error);
+    bool close(QString &error);
+
+private:
+    bool startPack(QString &error);
+
+    QMutex mutex;
+    QDir directory;
+    QFile index;
+    std::unique_ptr<QFile> pack;
+    int packNumber;
+    qint64 packSize;
+};
+
+class FrameArchiveReader
+{
+public:
+    struct Entry {
+        quint32 pack = 0;
+        quint64 offset = 0;
+        quint64 size = 0;
+    };
+
+    virtual ~FrameArchiveReader() = default;
+
+    bool open(const QString &directory, QString &error);
+    virtual void close();
+
+    QByteArray format() const { return imageFormat; } // "png", "jpg", "tiff" or "bmp"
+    QList<int> frameNumbers() const { return numbers; } // ascending
+    bool contains(int frameNumber) const { return entries.contains(frameNumber); }
+    // One pread on POSIX; safe to call from several threads at once
+    bool readFrame(int frameNumber, QByteArray &data, QString &error) const;
+
+protected:
+    QHash<int, Entry> entries;
+    QList<int> numbers;
+    QByteArray imageFormat;
+    std::vector<std::unique_ptr<QFile>> packs;
+
+private:
+    mutable QMutex seekMutex; // only used where there is no pread
+};
+
+// Maps every pack into memory; frame() returns the bytes without copying them
+class FrameArchiveMappedReader : public FrameArchiveReader
+{
+public:
+    bool open(const QString &directory, QString &error);
+    void close() override;
+    // Valid until the reader is closed or destroyed; empty if the frame is missing
+    QByteArray frame(int frameNumber) const;
+
+private:
+    std::vector<const uchar *> maps;
+};
+
+#endif // FRAMEARCHIVE_H
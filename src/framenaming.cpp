@@ -0,0 +1,110 @@
+// framenaming.cpp
+#include "framenaming.h"
+#include <QFile>
+#include <QFileInfo>
+
+namespace {
+
+// Enough for almost ten hours at 30 fps when the frame count is unknown
+const int UnknownCountPadding = 6;
+
+int digits(int value)
+{
+    int count = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+FrameNaming::FrameNaming(const ConversionSettings &settings, int frameCount)
+    : root(settings.outputPath)
+    , extension(settings.imageFormat.toLower())
+    , shardSize(qMax(0, settings.shardSize))
+{
+    width = settings.framePadding > 0 ? settings.framePadding
+            : frameCount > 0 ? qMax(4, digits(frameCount)) : UnknownCountPadding;
+
+    QString name = settings.nameTemplate.isEmpty() ? QString(DefaultTemplate) : settings.nameTemplate;
+    name.replace("{name}", QFileInfo(settings.inputPath).completeBaseName());
+    prefix = name.left(name.indexOf("{frame}"));
+}
+
+QString FrameNaming::validateTemplate(const QString &nameTemplate)
+{
+    if (nameTemplate.isEmpty()) return QString();
+    // The number has to end the name: image2 patterns and parseFrameNumber both read it from there
+    if (!nameTemplate.endsWith("{frame}") || nameTemplate.count("{frame}") != 1) {
+        return "The naming template must end with {frame}, e.g. \"shot_{frame}\".";
+    }
+    if (nameTemplate.contains('/') || nameTemplate.contains('\\')) {
+        return "The naming template cannot contain directory separators; use sharding for subdirectories.";
+    }
+    return QString();
+}
+
+QString FrameNaming::fileName(int number) const
+{
+    return QString("%1%2.%3").arg(prefix, QString("%1").arg(number, width, 10, QChar('0')), extension);
+}
+
+QString FrameNaming::shardName(int number) const
+{
+    int first = (number - 1) / shardSize * shardSize + 1;
+    return QString("%1").arg(first, width, 10, QChar('0'));
+}
+
+QString FrameNaming::relativePath(int number) const
+{
+    return isSharded() ? shardName(number) + '/' + fileName(number) : fileName(number);
+}
+
+QString FrameNaming::filePath(int number) const
+{
+    return root.absoluteFilePath(relativePath(number));
+}
+
+QString FrameNaming::ffmpegPattern() const
+{
+    QString escaped = prefix;
+    escaped.replace("%", "%%");
+    return root.absoluteFilePath(escaped + "%0" + QString::number(width) + "d." + extension);
+}
+
+bool FrameNaming::createShards(int frameCount, QString &error) const
+{
+    if (!isSharded()) return true;
+    for (int number = 1; number <= frameCount; number += shardSize) {
+        if (!root.mkpath(shardName(number))) {
+            error = QString("Failed to create output directory: %1").arg(root.absoluteFilePath(shardName(number)));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FrameNaming::moveIntoShards(QString &error, const std::function<bool()> &isCanceled) const
+{
+    if (!isSharded()) return true;
+    // Renames stay on one filesystem, so this is metadata work only
+    for (int number = 1; QFile::exists(root.absoluteFilePath(fileName(number))); ++number) {
+        if (isCanceled && isCanceled()) {
+            error = "Conversion cancelled.";
+            return false;
+        }
+        if ((number - 1) % shardSize == 0 && !root.mkpath(shardName(number))) {
+            error = QString("Failed to create output directory: %1").arg(root.absoluteFilePath(shardName(number)));
+            return false;
+        }
+        QString target = filePath(number);
+        QFile::remove(target);
+        if (!QFile::rename(root.absoluteFilePath(fileName(number)), target)) {
+            error = QString("Failed to move %1 into %2").arg(fileName(number), shardName(number));
+            return false;
+        }
+    }
+    return true;
+}
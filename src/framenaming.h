@@ -0,0 +1,46 @@
+// framenaming.h
+#ifndef FRAMENAMING_H
+#define FRAMENAMING_H
+
+#include <QString>
+#include <QDir>
+#include <functional>
+#include "converter.h"
+
+// File names for extracted frames. A template such as "shot_{name}_{frame}"
+// gives the name, {name} being the input's base name; the frame number is
+// zero-padded wide enough for the whole extraction. With a shard size, frames
+// go into subdirectories named after their first frame number (000001/,
+// 001001/, ...), which the sequence scanner and findImageFiles read back as
+// one sequence. Numbers start at 1, as image2 counts.
+class FrameNaming
+{
+public:
+    static constexpr const char *DefaultTemplate = "frame_{frame}";
+
+    // frameCount sizes the automatic padding; 0 when it is not known
+    FrameNaming(const ConversionSettings &settings, int frameCount);
+
+    static QString validateTemplate(const QString &nameTemplate); // empty if usable
+
+    int padding() const { return width; }
+    bool isSharded() const { return shardSize > 0; }
+    QString fileName(int number) const;
+    QString relativePath(int number) const; // shard directory included
+    QString filePath(int number) const;
+    QString ffmpegPattern() const;          // flat image2 output pattern
+    bool createShards(int frameCount, QString &error) const;
+    // Moves frames ffmpeg wrote flat into their shards; thread-safe, the converter runs it on a worker
+    bool moveIntoShards(QString &error, const std::function<bool()> &isCanceled = nullptr) const;
+
+private:
+    QString shardName(int number) const;
+
+    QDir root;
+    QString prefix;
+    QString extension;
+    int width;
+    int shardSize;
+};
+
+#endif // FRAMENAMING_H
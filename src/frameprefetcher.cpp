@@ -0,0 +1,83 @@
+// frameprefetcher.cpp
+#include "frameprefetcher.h"
+#include <QFile>
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <climits>
+#endif
+
+FramePrefetcher::FramePrefetcher(const QStringList &files, int depth, QObject *parent)
+    : QObject(parent)
+    , files(files)
+    , depth(qMax(1, depth))
+    , nextIndex(0)
+    , currentIndex(0)
+{
+    // Hints are latency-bound on NFS, not CPU-bound
+    pool.setMaxThreadCount(qBound(2, this->depth / 4, 8));
+}
+
+FramePrefetcher::~FramePrefetcher()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+QString FramePrefetcher::method()
+{
+#if defined(Q_OS_LINUX)
+    return "posix_fadvise(WILLNEED)";
+#elif defined(Q_OS_MACOS)
+    return "fcntl(F_RDADVISE)";
+#else
+    return "background reads";
+#endif
+}
+
+void FramePrefetcher::advanceTo(int index)
+{
+    currentIndex = index;
+    // Frames the encoder has already passed are not worth fetching
+    nextIndex = qMax(nextIndex, index);
+    int end = qMin(static_cast<int>(files.size()), index + depth);
+    for (; nextIndex < end; ++nextIndex) {
+        const int frame = nextIndex;
+        const QString path = files.at(frame);
+        pool.start([this, frame, path]() {
+            if (frame < currentIndex) return; // the encoder overtook this hint while it was queued
+            prefetchFile(path);
+        });
+    }
+}
+
+void FramePrefetcher::prefetchFile(const QString &path)
+{
+#if defined(Q_OS_LINUX)
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    // Starts asynchronous read-ahead of the whole file; the pages stay cached after close()
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+#elif defined(Q_OS_MACOS)
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        struct radvisory advice;
+        advice.ra_offset = 0;
+        advice.ra_count = static_cast<int>(qMin<off_t>(info.st_size, INT_MAX));
+        ::fcntl(fd, F_RDADVISE, &advice);
+    }
+    ::close(fd);
+#else
+    // No advisory call available: read the file on this worker thread to warm the cache
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return;
+    char buffer[64 * 1024];
+    while (file.read(buffer, sizeof(buffer)) > 0) {
+    }
+#endif
+}
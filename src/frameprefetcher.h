@@ -0,0 +1,37 @@
+// frameprefetcher.h
+#ifndef FRAMEPREFETCHER_H
+#define FRAMEPREFETCHER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+
+// Warms the page cache for the frames just ahead of the encoder, so ffmpeg
+// doesn't wait a network round trip for every file it opens. The caller
+// reports the frame ffmpeg has reached and at most `depth` frames beyond it
+// are requested, each with a read-ahead hint issued on a small thread pool.
+class FramePrefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    FramePrefetcher(const QStringList &files, int depth, QObject *parent = nullptr);
+    ~FramePrefetcher();
+
+    void advanceTo(int index);
+    int requested() const { return nextIndex; }
+
+    static QString method();
+
+private:
+    static void prefetchFile(const QString &path);
+
+    QStringList files;
+    int depth;
+    int nextIndex; // first frame not yet requested
+    std::atomic<int> currentIndex;
+    QThreadPool pool;
+};
+
+#endif // FRAMEPREFETCHER_H
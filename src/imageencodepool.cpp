@@ -0,0 +1,174 @@
+// imageencodepool.cpp
+#include "imageencodepool.h"
+#include "framearchive.h"
+#include <QImage>
+#include <QImageWriter>
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QCryptographicHash>
+
+ImageEncodePool::ImageEncodePool(int width, int height, int threadCount, QObject *parent)
+    : QObject(parent)
+    , width(width)
+    , height(height)
+    , bytesPerFrame(static_cast<qint64>(width) * height * 3)
+    , compression(-1)
+    , hashFrames(false)
+    , archive(nullptr)
+    , inFlight(0)
+    , canceled(false)
+{
+    threadCount = qMax(1, threadCount);
+    threads.setMaxThreadCount(threadCount);
+
+    // Two buffers per thread: one being encoded, one being filled from the pipe
+    for (int i = 0; i < threadCount * 2; ++i) {
+        buffers.emplace_back(new char[bytesPerFrame]);
+        freeList.append(i);
+    }
+}
+
+ImageEncodePool::~ImageEncodePool()
+{
+    cancel();
+    threads.waitForDone();
+}
+
+void ImageEncodePool::setOutput(const QString &outputDirectory, const std::function<QString(int)> &pathForFrame,
+                                const QByteArray &imageFormat, int level, bool hash)
+{
+    directory = QDir(outputDirectory).absolutePath();
+    relativePath = pathForFrame;
+    format = imageFormat;
+    compression = level;
+    hashFrames = hash;
+}
+
+void ImageEncodePool::setArchive(FrameArchiveWriter *writer)
+{
+    archive = writer;
+}
+
+bool ImageEncodePool::supportsFormat(const QString &imageFormat)
+{
+    // EXR has no Qt writer; those extractions stay on the ffmpeg encoder
+    QByteArray name = imageFormat.toLower().toLatin1();
+    if (name == "jpeg") name = "jpg";
+    if (name == "tif") name = "tiff";
+    return (name == "png" || name == "jpg" || name == "tiff" || name == "bmp")
+           && QImageWriter::supportedImageFormats().contains(name);
+}
+
+bool ImageEncodePool::encodeImage(const QImage &image, const QByteArray &format, int compression, QByteArray &encoded)
+{
+    QBuffer device(&encoded);
+    device.open(QIODevice::WriteOnly);
+    QImageWriter writer(&device, format);
+    if (compression >= 0) {
+        if (format == "png") {
+            // Qt's PNG writer derives the zlib level from quality as (100 - quality) * 9 / 91
+            writer.setQuality(100 - (compression * 91 + 8) / 9);
+        } else if (format == "tiff") {
+            writer.setCompression(compression > 0 ? 1 : 0); // LZW or none
+        } else if (format == "jpg") {
+            writer.setQuality(100 - compression * 10);
+        }
+    }
+    return writer.write(image);
+}
+
+int ImageEncodePool::acquireBuffer()
+{
+    QMutexLocker lock(&mutex);
+    return freeList.isEmpty() ? -1 : freeList.takeLast();
+}
+
+char *ImageEncodePool::bufferData(int buffer)
+{
+    return buffers[buffer].get();
+}
+
+void ImageEncodePool::submit(int buffer, int frameNumber)
+{
+    {
+        QMutexLocker lock(&mutex);
+        inFlight++;
+    }
+    threads.start([this, buffer, frameNumber]() { encode(buffer, frameNumber); });
+}
+
+void ImageEncodePool::cancel()
+{
+    canceled = true;
+    threads.clear();
+}
+
+int ImageEncodePool::pending() const
+{
+    QMutexLocker lock(&mutex);
+    return inFlight;
+}
+
+int ImageEncodePool::freeBuffers() const
+{
+    QMutexLocker lock(&mutex);
+    return freeList.size();
+}
+
+QList<ImageEncodePool::WrittenFrame> ImageEncodePool::writtenFrames() const
+{
+    QMutexLocker lock(&mutex);
+    return written;
+}
+
+void ImageEncodePool::encode(int buffer, int frameNumber)
+{
+    QString name = relativePath(frameNumber);
+    QDir outputDirectory(directory);
+    QString path = outputDirectory.absoluteFilePath(name);
+    QByteArray encoded;
+    bool ok = false;
+
+    if (!canceled) {
+        QImage image(reinterpret_cast<const uchar *>(buffers[buffer].get()), width, height, width * 3,
+                     QImage::Format_RGB888);
+        ok = encodeImage(image, format, compression, encoded);
+    }
+
+    // The raw frame is no longer needed once encoded; hand the buffer back before the write
+    {
+        QMutexLocker lock(&mutex);
+        freeList.append(buffer);
+    }
+    emit bufferReleased();
+
+    QString error;
+    if (canceled) {
+        error = "cancelled";
+        ok = false;
+    } else if (!ok) {
+        error = QString("Failed to encode frame %1").arg(frameNumber);
+    } else if (archive) {
+        ok = archive->append(frameNumber, encoded, error);
+        name = QString("frame %1").arg(frameNumber);
+    } else {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            // A shard past the probed frame count has not been created yet
+            outputDirectory.mkpath(QFileInfo(name).path());
+        }
+        ok = (file.isOpen() || file.open(QIODevice::WriteOnly | QIODevice::Truncate)) && file.write(encoded) == encoded.size();
+        if (!ok) error = QString("Failed to write %1: %2").arg(path, file.errorString());
+    }
+
+    WrittenFrame frame{frameNumber, name, encoded.size(), QByteArray()};
+    if (ok && hashFrames) frame.md5 = QCryptographicHash::hash(encoded, QCryptographicHash::Md5).toHex();
+
+    QMutexLocker lock(&mutex);
+    inFlight--;
+    if (ok) written.append(frame);
+    lock.unlock();
+    emit frameWritten(frameNumber, ok, error);
+}
@@ -0,0 +1,84 @@
+// imageencodepool.h
+#ifndef IMAGEENCODEPOOL_H
+#define IMAGEENCODEPOOL_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include <QList>
+#include <QByteArray>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class FrameArchiveWriter;
+class QImage;
+
+// Encodes raw RGB24 frames to image files on a pool of threads. Frames are
+// read straight into a fixed set of pooled buffers (acquireBuffer/submit),
+// so memory stays bounded: when every buffer is busy the producer has to
+// wait for bufferReleased().
+class ImageEncodePool : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct WrittenFrame {
+        int number;
+        QString file; // relative to the output directory
+        qint64 size;
+        QByteArray md5; // hex, empty unless hashing was requested
+    };
+
+    ImageEncodePool(int width, int height, int threads, QObject *parent = nullptr);
+    ~ImageEncodePool();
+
+    // Frames go to directory/relativePath(number); compression is 0 (fastest) to 9, -1 for the writer default
+    void setOutput(const QString &directory, const std::function<QString(int)> &relativePath,
+                   const QByteArray &format, int compression, bool hashFrames);
+    // Append encoded frames to a pack archive instead of writing one file each; not owned
+    void setArchive(FrameArchiveWriter *archive);
+
+    qint64 frameBytes() const { return bytesPerFrame; }
+    int acquireBuffer(); // -1 when all buffers are in use
+    char *bufferData(int buffer);
+    void submit(int buffer, int frameNumber);
+    void cancel();
+
+    int pending() const;
+    int freeBuffers() const;
+    int bufferCount() const { return static_cast<int>(buffers.size()); }
+    QList<WrittenFrame> writtenFrames() const;
+
+    static bool supportsFormat(const QString &format);
+    // Encodes one image the way the pool's workers do; format is the writer name ("jpg", "tiff")
+    static bool encodeImage(const QImage &image, const QByteArray &format, int compression, QByteArray &encoded);
+
+signals:
+    void bufferReleased();
+    void frameWritten(int frameNumber, bool success, const QString &error);
+
+private:
+    void encode(int buffer, int frameNumber);
+
+    int width;
+    int height;
+    qint64 bytesPerFrame;
+    QString directory; // absolute; each worker builds its own QDir
+    std::function<QString(int)> relativePath;
+    QByteArray format;
+    int compression;
+    bool hashFrames;
+    FrameArchiveWriter *archive;
+
+    std::vector<std::unique_ptr<char[]>> buffers;
+    QThreadPool threads;
+    mutable QMutex mutex;
+    QList<int> freeList;
+    int inFlight;
+    QList<WrittenFrame> written;
+    std::atomic<bool> canceled;
+};
+
+#endif // IMAGEENCODEPOOL_H
@@ -0,0 +1,298 @@
+// jobjournal.cpp
+#include "jobjournal.h"
+#include "presetmanager.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QMap>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+const int MaxHistory = 1000;
+
+ConversionJob::State stateFromName(const QString &name)
+{
+    if (name == "Done") return ConversionJob::Done;
+    if (name == "Failed") return ConversionJob::Failed;
+    if (name == "Canceled") return ConversionJob::Canceled;
+    return ConversionJob::Queued;
+}
+
+} // namespace
+
+JobJournal::JobJournal(const QString &path)
+    : file(path)
+    , records(0)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+}
+
+QJsonObject JobJournal::jobToJson(const ConversionJob &job)
+{
+    QJsonObject o;
+    o["kind"] = job.kind == ConversionJob::VideoToSequence ? "videoToSequence" : "sequenceToVideo";
+    o["priority"] = job.priority;
+    o["label"] = job.label;
+    o["sequencePrefix"] = job.sequencePrefix;
+    o["sequenceExtension"] = job.sequenceExtension;
+    o["settings"] = PresetManager::settingsToJson(job.settings);
+    return o;
+}
+
+QByteArray JobJournal::jobKey(const ConversionJob &job)
+{
+    QJsonObject o = jobToJson(job);
+    o.remove("priority");
+    o.remove("label");
+    return QCryptographicHash::hash(QJsonDocument(o).toJson(QJsonDocument::Compact), QCryptographicHash::Sha1).toHex();
+}
+
+QList<ConversionJob> JobJournal::replay(QList<int> &interrupted)
+{
+    QMap<int, ConversionJob> jobs;
+    QMap<int, bool> started;
+    records = 0;
+    historyEntries.clear();
+
+    if (file.isOpen()) file.close();
+    if (file.open(QIODevice::ReadOnly)) {
+        while (!file.atEnd()) {
+            QByteArray line = file.readLine().trimmed();
+            if (line.isEmpty()) continue;
+            QJsonObject record = QJsonDocument::fromJson(line).object();
+            if (record.isEmpty()) continue; // torn write from a crash mid-append
+            records++;
+
+            int id = record["id"].toInt();
+            QString op = record["op"].toString();
+            if (op == "submit") {
+                QJsonObject o = record["job"].toObject();
+                ConversionJob job;
+                job.id = id;
+                job.kind = o["kind"].toString() == "videoToSequence" ? ConversionJob::VideoToSequence
+                                                                    : ConversionJob::SequenceToVideo;
+                job.priority = o["priority"].toInt();
+                job.label = o["label"].toString();
+                job.sequencePrefix = o["sequencePrefix"].toString();
+                job.sequenceExtension = o["sequenceExtension"].toString();
+                job.settings = PresetManager::jsonToSettings(o["settings"].toObject());
+                jobs.insert(id, job);
+            } else if (op == "history") {
+                // Kept whether or not the job itself is still listed
+                HistoryEntry entry;
+                entry.id = id;
+                entry.key = record["key"].toString().toLatin1();
+                entry.input = record["input"].toObject();
+                entry.output = record["output"].toObject();
+                remember(entry);
+            } else if (!jobs.contains(id)) {
+                continue;
+            } else if (op == "start") {
+                started[id] = true;
+            } else if (op == "defer") {
+                started.remove(id);
+                jobs[id].checkpoint = 0;
+            } else if (op == "progress") {
+                jobs[id].checkpoint = record["percent"].toInt();
+            } else if (op == "finish") {
+                ConversionJob &job = jobs[id];
+                job.state = stateFromName(record["state"].toString());
+                job.message = record["message"].toString();
+                job.elapsedMs = record["elapsedMs"].toVariant().toLongLong();
+                job.pausedMs = record["pausedMs"].toVariant().toLongLong();
+                job.fingerprint = record["fingerprint"].toObject();
+            } else if (op == "remove") {
+                jobs.remove(id);
+                started.remove(id);
+            }
+        }
+        file.close();
+    }
+
+    interrupted.clear();
+    for (const ConversionJob &job : jobs) {
+        if (job.state == ConversionJob::Queued && started.value(job.id)) interrupted.append(job.id);
+    }
+    return jobs.values();
+}
+
+void JobJournal::append(const QJsonObject &record, bool sync)
+{
+    if (!file.isOpen() && !file.open(QIODevice::WriteOnly | QIODevice::Append)) return;
+
+    QJsonObject stamped = record;
+    stamped["time"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs);
+    file.write(QJsonDocument(stamped).toJson(QJsonDocument::Compact) + '\n');
+    file.flush();
+#ifdef Q_OS_UNIX
+    // Submissions and completions must survive a power cut; progress checkpoints needn't
+    if (sync) ::fsync(file.handle());
+#else
+    Q_UNUSED(sync);
+#endif
+    records++;
+}
+
+void JobJournal::recordSubmit(const ConversionJob &job)
+{
+    append({{"op", "submit"}, {"id", job.id}, {"job", jobToJson(job)}}, true);
+}
+
+void JobJournal::recordStart(int id)
+{
+    append({{"op", "start"}, {"id", id}}, false);
+}
+
+void JobJournal::recordDefer(int id)
+{
+    append({{"op", "defer"}, {"id", id}}, false);
+}
+
+void JobJournal::recordProgress(int id, int percentage)
+{
+    append({{"op", "progress"}, {"id", id}, {"percent", percentage}}, false);
+}
+
+void JobJournal::recordFinish(const ConversionJob &job)
+{
+    append({{"op", "finish"}, {"id", job.id}, {"state", JobQueue::stateName(job.state)},
+            {"message", job.message}, {"elapsedMs", job.elapsedMs}, {"pausedMs", job.pausedMs},
+            {"fingerprint", job.fingerprint}}, true);
+}
+
+void JobJournal::recordRemove(int id)
+{
+    append({{"op", "remove"}, {"id", id}}, false);
+}
+
+void JobJournal::recordHistory(const HistoryEntry &entry)
+{
+    remember(entry);
+    append(historyToJson(entry), true);
+}
+
+QList<JobJournal::HistoryEntry> JobJournal::history(const QByteArray &key) const
+{
+    QList<HistoryEntry> matching;
+    for (const HistoryEntry &entry : historyEntries) {
+        if (entry.key == key) matching.append(entry);
+    }
+    return matching;
+}
+
+QJsonObject JobJournal::historyToJson(const HistoryEntry &entry)
+{
+    return {{"op", "history"}, {"id", entry.id}, {"key", QString::fromLatin1(entry.key)},
+            {"input", entry.input}, {"output", entry.output}};
+}
+
+void JobJournal::remember(const HistoryEntry &entry)
+{
+    // The latest run of the same work replaces the earlier one
+    for (int i = 0; i < historyEntries.size(); ++i) {
+        if (historyEntries.at(i).key == entry.key) {
+            historyEntries.removeAt(i);
+            break;
+        }
+    }
+    historyEntries.append(entry);
+    while (historyEntries.size() > MaxHistory) historyEntries.removeFirst();
+}
+
+bool JobJournal::needsCompaction(int liveJobs) const
+{
+    // Each live job needs at most two records (submit and finish) after compaction, plus the history
+    return records > 4 * liveJobs + historyEntries.size() + 256;
+}
+
+bool JobJournal::compact(const QList<ConversionJob> &jobs)
+{
+    // Written to a temporary file and renamed over the log, so a crash leaves one or the other
+    QSaveFile rewrite(file.fileName());
+    if (!rewrite.open(QIODevice::WriteOnly)) return false;
+
+    int written = 0;
+    QString now = QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs);
+    for (const HistoryEntry &entry : historyEntries) {
+        QJsonObject record = historyToJson(entry);
+        record["time"] = now;
+        rewrite.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n');
+        written++;
+    }
+    for (const ConversionJob &job : jobs) {
+        QJsonObject submit{{"op", "submit"}, {"id", job.id}, {"job", jobToJson(job)}, {"time", now}};
+        rewrite.write(QJsonDocument(submit).toJson(QJsonDocument::Compact) + '\n');
+        written++;
+        if (job.state == ConversionJob::Done || job.state == ConversionJob::Failed
+            || job.state == ConversionJob::Canceled) {
+            QJsonObject finish{{"op", "finish"}, {"id", job.id}, {"state", JobQueue::stateName(job.state)},
+                               {"message", job.message}, {"elapsedMs", job.elapsedMs}, {"pausedMs", job.pausedMs},
+                               {"fingerprint", job.fingerprint}, {"time", now}};
+            rewrite.write(QJsonDocument(finish).toJson(QJsonDocument::Compact) + '\n');
+            written++;
+        }
+    }
+
+    if (file.isOpen()) file.close();
+    if (!rewrite.commit()) return false;
+    records = written;
+    return true;
+}
+
+QJsonObject JobJournal::outputFingerprint(const QString &outputPath)
+{
+    QFileInfo info(outputPath);
+    if (!info.exists()) return QJsonObject();
+
+    QJsonObject fingerprint;
+    fingerprint["path"] = info.absoluteFilePath();
+    if (info.isDir()) {
+        // Extracted sequences: file count, total size and newest modification, shards and
+        // frame archives (pack and index) included
+        qint64 files = 0;
+        qint64 bytes = 0;
+        qint64 newest = 0;
+        QDirIterator it(info.absoluteFilePath(), QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            files++;
+            bytes += it.fileInfo().size();
+            newest = qMax(newest, it.fileInfo().lastModified().toMSecsSinceEpoch());
+        }
+        fingerprint["files"] = files;
+        fingerprint["size"] = bytes;
+        fingerprint["modified"] = newest;
+    } else {
+        fingerprint["size"] = info.size();
+        fingerprint["modified"] = info.lastModified().toMSecsSinceEpoch();
+    }
+    return fingerprint;
+}
+
+bool JobJournal::fingerprintMatches(const QJsonObject &fingerprint)
+{
+    return !fingerprint.isEmpty() && outputFingerprint(fingerprint["path"].toString()) == fingerprint;
+}
+
+QJsonObject JobJournal::inputFingerprint(const QString &inputPath, const QStringList &files)
+{
+    const QStringList paths = files.isEmpty() ? QStringList{inputPath} : files;
+    qint64 bytes = 0;
+    qint64 newest = 0;
+    for (const QString &path : paths) {
+        QFileInfo info(path);
+        if (!info.isFile()) return QJsonObject();
+        bytes += info.size();
+        newest = qMax(newest, info.lastModified().toMSecsSinceEpoch());
+    }
+    return {{"path", QFileInfo(inputPath).absoluteFilePath()}, {"files", paths.size()},
+            {"size", bytes}, {"modified", newest}};
+}
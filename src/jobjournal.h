@@ -0,0 +1,66 @@
+// jobjournal.h
+#ifndef JOBJOURNAL_H
+#define JOBJOURNAL_H
+
+#include <QFile>
+#include <QJsonObject>
+#include <QList>
+#include "jobqueue.h"
+
+// Append-only log of job events, one JSON object per line: submit, start,
+// defer (back to waiting before it wrote anything), progress checkpoints,
+// finish and remove, plus a history record for each
+// successful job pairing its input and output fingerprints. Replaying it
+// rebuilds the queue after a crash or reboot; a torn last line is ignored.
+// The log is rewritten from the live jobs and the history from time to time
+// so it doesn't grow without bound. History outlives removed jobs, so work
+// cleared from the list is still recognised when it is queued again.
+class JobJournal
+{
+public:
+    struct HistoryEntry {
+        int id = 0; // the job that produced the output
+        QByteArray key;
+        QJsonObject input;
+        QJsonObject output;
+    };
+
+    explicit JobJournal(const QString &path);
+
+    // Rebuilds jobs from the log; jobs that never finished come back as Queued
+    QList<ConversionJob> replay(QList<int> &interrupted);
+
+    void recordSubmit(const ConversionJob &job);
+    void recordStart(int id);
+    void recordDefer(int id);
+    void recordProgress(int id, int percentage);
+    void recordFinish(const ConversionJob &job);
+    void recordRemove(int id);
+    void recordHistory(const HistoryEntry &entry);
+    QList<HistoryEntry> history(const QByteArray &key) const;
+
+    bool needsCompaction(int liveJobs) const;
+    bool compact(const QList<ConversionJob> &jobs);
+
+    QString path() const { return file.fileName(); }
+
+    // Size and modification time of the output file, or of the files in an output directory
+    static QJsonObject outputFingerprint(const QString &outputPath);
+    static bool fingerprintMatches(const QJsonObject &fingerprint);
+    // Size and modification time of the input: the video file, or the frames a sequence job selected
+    static QJsonObject inputFingerprint(const QString &inputPath, const QStringList &files);
+    // Identifies "the same work": kind, settings and the sequence selected
+    static QByteArray jobKey(const ConversionJob &job);
+
+private:
+    void append(const QJsonObject &record, bool sync);
+    static QJsonObject jobToJson(const ConversionJob &job);
+    static QJsonObject historyToJson(const HistoryEntry &entry);
+    void remember(const HistoryEntry &entry);
+
+    QFile file;
+    QList<HistoryEntry> historyEntries; // oldest first, one per key
+    int records; // lines in the file, for the compaction threshold
+};
+
+#endif // JOBJOURNAL_H
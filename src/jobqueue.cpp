@@ -0,0 +1,574 @@
+// jobqueue.cpp
+#include "jobqueue.h"
+#include "jobjournal.h"
+#include "concurrencycontroller.h"
+#include "tracerecorder.h"
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <algorithm>
+#include <QtConcurrent/QtConcurrentRun>
+
+JobQueue::JobQueue(QObject *parent)
+    : QObject(parent)
+    , preemptPending(false)
+    , maxRunning(1)
+    , controller(new ConcurrencyController(this))
+    , trace(nullptr)
+    , nextId(1)
+{
+    // The ceiling is the user's job count, not the core count, until they raise it
+    controller->setMaximumJobs(maxRunning);
+    controller->setSource([this]() {
+        ConcurrencyController::Snapshot snapshot;
+        for (int id : std::as_const(activeIds)) {
+            const Worker &worker = workers[id];
+            snapshot.running.insert(id, {worker.converter ? worker.converter->processId() : 0, worker.frames});
+        }
+        for (const ConversionJob &job : std::as_const(jobList)) {
+            if (job.state == ConversionJob::Queued || (job.state == ConversionJob::Paused && !job.held)) snapshot.waiting++;
+        }
+        return snapshot;
+    });
+    connect(controller, &ConcurrencyController::logMessage, this, &JobQueue::logMessage);
+    connect(controller, &ConcurrencyController::limitChanged, this, [this]() { schedule(); });
+}
+
+JobQueue::~JobQueue()
+{
+}
+
+QString JobQueue::defaultJournalPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/jobs.journal";
+}
+
+void JobQueue::openJournal(const QString &path)
+{
+    journal = std::make_unique<JobJournal>(path);
+    QList<int> interrupted;
+    const QList<ConversionJob> restored = journal->replay(interrupted);
+
+    // Queued jobs whose output is already complete are recognised when they are prepared
+    int requeued = 0;
+    for (const ConversionJob &job : restored) {
+        nextId = qMax(nextId, job.id + 1);
+        if (job.state == ConversionJob::Queued && interrupted.contains(job.id)) {
+            emit logMessage(QString("Re-queued interrupted job %1 (stopped at %2%): %3")
+                            .arg(job.id).arg(job.checkpoint).arg(job.label));
+            requeued++;
+        }
+        if (trace && job.state == ConversionJob::Queued) queuedSince.insert(job.id, trace->now());
+        jobList.append(job);
+    }
+    compactJournalIfNeeded();
+
+    if (!restored.isEmpty()) {
+        emit logMessage(QString("Job journal: %1 job(s) restored, %2 interrupted re-queued.")
+                        .arg(restored.size()).arg(requeued));
+    }
+    emit queueChanged();
+    schedule();
+}
+
+void JobQueue::recordHistory(int id, const QJsonObject &input)
+{
+    int index = indexOf(id);
+    if (!journal || index < 0 || input.isEmpty()) return;
+
+    // Measuring an extracted sequence walks the whole directory, so it is done on a worker
+    JobJournal::HistoryEntry entry;
+    entry.id = id;
+    entry.key = JobJournal::jobKey(jobList.at(index));
+    entry.input = input;
+    QString outputPath = jobList.at(index).settings.outputPath;
+    auto *watcher = new QFutureWatcher<QJsonObject>(this);
+    connect(watcher, &QFutureWatcher<QJsonObject>::finished, this, [this, watcher, entry]() mutable {
+        watcher->deleteLater();
+        entry.output = watcher->result();
+        if (entry.output.isEmpty() || !journal) return;
+        journal->recordHistory(entry);
+        int index = indexOf(entry.id);
+        if (index >= 0) jobList[index].fingerprint = entry.output;
+    });
+    watcher->setFuture(QtConcurrent::run([outputPath]() { return JobJournal::outputFingerprint(outputPath); }));
+}
+
+void JobQueue::compactJournalIfNeeded()
+{
+    if (journal && journal->needsCompaction(jobList.size())) {
+        journal->compact(jobList);
+    }
+}
+
+void JobQueue::setMaxRunning(int jobs)
+{
+    maxRunning = qMax(1, jobs);
+    controller->setMaximumJobs(maxRunning);
+    schedule();
+}
+
+void JobQueue::setAdaptiveConcurrency(bool enabled)
+{
+    if (enabled && !ConcurrencyController::isSupported()) {
+        emit logMessage("Adaptive concurrency needs /proc (Linux); keeping a fixed number of jobs.");
+        return;
+    }
+    if (!enabled && controller->isEnabled()) {
+        emit logMessage(QString("Adaptive concurrency off: back to %1 job(s) at once.").arg(maxRunning));
+    }
+    controller->setEnabled(enabled);
+    schedule();
+}
+
+void JobQueue::setTraceRecorder(TraceRecorder *recorder)
+{
+    trace = recorder;
+}
+
+int JobQueue::runningLimit() const
+{
+    return controller->isEnabled() ? controller->jobLimit() : maxRunning;
+}
+
+int JobQueue::enqueue(const ConversionJob &job)
+{
+    ConversionJob queued = job;
+    queued.id = nextId++;
+    queued.state = ConversionJob::Queued;
+    if (journal) journal->recordSubmit(queued);
+    if (trace) queuedSince.insert(queued.id, trace->now());
+    jobList.append(queued);
+    emit queueChanged();
+    schedule();
+    return queued.id;
+}
+
+bool JobQueue::pauseJob(int id)
+{
+    int index = indexOf(id);
+    if (index < 0 || !activeIds.contains(id) || !workers.value(id).converter->pause()) return false;
+
+    jobList[index].state = ConversionJob::Paused;
+    jobList[index].held = true;
+    activeIds.removeAll(id);
+    emit logMessage(QString("Job %1 paused.").arg(id));
+    emit queueChanged();
+    schedule(); // the freed cores go to the next job
+    return true;
+}
+
+bool JobQueue::resumeJob(int id)
+{
+    int index = indexOf(id);
+    if (index < 0 || jobList.at(index).state != ConversionJob::Paused) return false;
+
+    jobList[index].held = false;
+    schedule();
+    if (jobList.at(index).state == ConversionJob::Paused) {
+        emit logMessage(QString("Job %1 will resume when a running job finishes.").arg(id));
+    }
+    emit queueChanged();
+    return true;
+}
+
+void JobQueue::cancelAll()
+{
+    for (ConversionJob &job : jobList) {
+        if (job.state != ConversionJob::Queued) continue;
+        job.state = ConversionJob::Canceled;
+        job.message = "Job cancelled before it started.";
+        deferred.remove(job.id);
+        queuedSince.remove(job.id);
+        if (journal) journal->recordFinish(job);
+    }
+    // Paused jobs are killed too; SIGKILL is delivered to stopped processes
+    const QList<int> ids = workers.keys();
+    for (int id : ids) {
+        if (!workers.contains(id)) continue; // finished synchronously by an earlier cancel
+        Worker &worker = workers[id];
+        worker.cancelRequested = true;
+        if (worker.preparer && worker.preparer->isRunning()) {
+            worker.preparer->cancel(); // onJobPrepared marks the job
+        } else {
+            worker.converter->cancel(); // onJobFinished marks the job
+        }
+    }
+    emit queueChanged();
+}
+
+void JobQueue::clearFinished()
+{
+    for (const ConversionJob &job : jobList) {
+        bool finished = job.state == ConversionJob::Done || job.state == ConversionJob::Failed
+                        || job.state == ConversionJob::Canceled;
+        if (finished && journal) journal->recordRemove(job.id);
+        if (finished) {
+            queuedSince.remove(job.id);
+            deferred.remove(job.id);
+        }
+    }
+    jobList.erase(std::remove_if(jobList.begin(), jobList.end(), [](const ConversionJob &job) {
+        return job.state == ConversionJob::Done || job.state == ConversionJob::Failed
+               || job.state == ConversionJob::Canceled;
+    }), jobList.end());
+    compactJournalIfNeeded();
+    emit queueChanged();
+}
+
+bool JobQueue::isRunning() const
+{
+    return !workers.isEmpty();
+}
+
+QList<ConversionJob> JobQueue::jobs() const
+{
+    return jobList;
+}
+
+QString JobQueue::stateName(ConversionJob::State state)
+{
+    switch (state) {
+    case ConversionJob::Queued: return "Queued";
+    case ConversionJob::Running: return "Running";
+    case ConversionJob::Paused: return "Paused";
+    case ConversionJob::Done: return "Done";
+    case ConversionJob::Failed: return "Failed";
+    case ConversionJob::Canceled: return "Canceled";
+    }
+    return QString();
+}
+
+QString JobQueue::priorityName(int priority)
+{
+    if (priority > ConversionJob::Normal) return "Urgent";
+    if (priority < ConversionJob::Normal) return "Low";
+    return "Normal";
+}
+
+int JobQueue::indexOf(int id) const
+{
+    for (int i = 0; i < jobList.size(); ++i) {
+        if (jobList.at(i).id == id) return i;
+    }
+    return -1;
+}
+
+int JobQueue::leastUrgentActive() const
+{
+    // Lowest priority; among equals the one that got its slot last
+    int victim = -1;
+    int victimPriority = 0;
+    for (int id : activeIds) {
+        int priority = jobList.at(indexOf(id)).priority;
+        if (victim < 0 || priority <= victimPriority) {
+            victim = id;
+            victimPriority = priority;
+        }
+    }
+    return victim;
+}
+
+bool JobQueue::preempt(int id, const QString &reason)
+{
+    if (!workers[id].converter->pause()) {
+        // Still listing frames or auto-tuning; retry on its next progress report
+        preemptPending = true;
+        return false;
+    }
+    jobList[indexOf(id)].state = ConversionJob::Paused;
+    activeIds.removeAll(id);
+    emit logMessage(QString("Job %1 %2.").arg(id).arg(reason));
+    return true;
+}
+
+void JobQueue::schedule()
+{
+    preemptPending = false;
+    const int limit = runningLimit();
+
+    // The limit was lowered: stop the least urgent jobs until it holds
+    while (activeIds.size() > limit) {
+        if (!preempt(leastUrgentActive(), QString("paused to bring concurrency down to %1").arg(limit))) break;
+    }
+
+    for (;;) {
+        // Best waiting job: highest priority, then one already started (paused), then oldest
+        int candidate = -1;
+        for (int i = 0; i < jobList.size(); ++i) {
+            const ConversionJob &job = jobList.at(i);
+            bool waiting = (job.state == ConversionJob::Queued && !deferred.contains(job.id))
+                           || (job.state == ConversionJob::Paused && !job.held);
+            if (!waiting) continue;
+            if (candidate < 0) {
+                candidate = i;
+                continue;
+            }
+            const ConversionJob &best = jobList.at(candidate);
+            if (job.priority > best.priority
+                || (job.priority == best.priority && job.state == ConversionJob::Paused && best.state == ConversionJob::Queued)) {
+                candidate = i;
+            }
+        }
+        if (candidate < 0) return;
+
+        if (activeIds.size() >= limit) {
+            int victim = leastUrgentActive();
+            if (victim < 0 || jobList.at(candidate).priority <= jobList.at(indexOf(victim)).priority) return;
+            QString reason = QString("preempted by %1 priority job %2")
+                             .arg(priorityName(jobList.at(candidate).priority).toLower()).arg(jobList.at(candidate).id);
+            if (!preempt(victim, reason)) return;
+        }
+
+        ConversionJob &job = jobList[candidate];
+        activeIds.append(job.id);
+        if (job.state == ConversionJob::Paused) {
+            job.state = ConversionJob::Running;
+            workers[job.id].converter->resume();
+            emit logMessage(QString("Job %1 resumed.").arg(job.id));
+            emit queueChanged();
+        } else {
+            startJob(job); // may finish the job synchronously, so the loop rescans
+        }
+    }
+}
+
+void JobQueue::startJob(ConversionJob &job)
+{
+    const int id = job.id;
+    job.state = ConversionJob::Running;
+    job.checkpoint = 0; // a re-queued job starts over
+
+    Worker &worker = workers[id];
+    worker.converter = new Converter(this);
+    worker.clock.start();
+    worker.threads = controller->isEnabled() ? controller->threadsPerJob() : 0;
+    if (trace) {
+        // Lowest slot no other started job holds, so tracks stay few and dense
+        QList<int> taken;
+        for (auto it = workers.cbegin(); it != workers.cend(); ++it) {
+            if (it.key() != id) taken.append(it.value().slot);
+        }
+        while (taken.contains(worker.slot)) worker.slot++;
+        int track = TraceRecorder::FirstSlotTrack + worker.slot;
+        trace->nameTrack(track, QString("Slot %1").arg(worker.slot + 1));
+        trace->asyncSpan(id, QString("queued #%1").arg(id), "queue", queuedSince.contains(id) ? queuedSince.take(id) : -1,
+                         {{"label", job.label}, {"priority", priorityName(job.priority)}});
+        worker.startUs = trace->now();
+        worker.converter->setTrace(trace, track);
+    }
+    connect(worker.converter, &Converter::finished, this, [this, id](bool success, const QString &message) {
+        onJobFinished(id, success, message);
+    });
+    connect(worker.converter, &Converter::logMessage, this, &JobQueue::logMessage);
+    connect(worker.converter, &Converter::progressChanged, this, [this, id](int percentage) {
+        emit jobProgress(id, percentage);
+        if (workers.contains(id)) workers[id].percent = percentage;
+        int index = indexOf(id);
+        if (journal && index >= 0 && percentage >= jobList.at(index).checkpoint + 10) {
+            jobList[index].checkpoint = percentage;
+            journal->recordProgress(id, percentage);
+        }
+        if (preemptPending && activeIds.contains(id)) schedule();
+    });
+    connect(worker.converter, &Converter::frameProgress, this, [this, id](int frames) {
+        if (workers.contains(id)) workers[id].frames = frames;
+    });
+
+    if (journal) journal->recordStart(id);
+    emit queueChanged();
+    emit jobStarted(id);
+    emit logMessage(QString("Starting job %1: %2").arg(id).arg(job.label));
+
+    // List frames and estimate the output off the GUI thread; nothing is written until it is admitted
+    ConversionJob::Kind kind = job.kind;
+    ConversionSettings settings = job.settings;
+    QString prefix = job.sequencePrefix;
+    QString extension = job.sequenceExtension;
+    QList<JobJournal::HistoryEntry> history = journal ? journal->history(JobJournal::jobKey(job)) : QList<JobJournal::HistoryEntry>();
+    if (trace) worker.listUs = trace->now();
+    worker.preparer = new QFutureWatcher<Preparation>(this);
+    connect(worker.preparer, &QFutureWatcher<Preparation>::finished, this, [this, id]() { onJobPrepared(id); });
+    worker.preparer->setFuture(QtConcurrent::run([kind, settings, prefix, extension, history](QPromise<Preparation> &promise) {
+        Preparation preparation;
+        // The same work finished before, from the same input, and its output is still exactly what it produced
+        auto completeFromHistory = [&history, &preparation]() {
+            for (const JobJournal::HistoryEntry &entry : history) {
+                if (!preparation.input.isEmpty() && entry.input == preparation.input
+                    && JobJournal::fingerprintMatches(entry.output)) {
+                    preparation.completedBy = entry.id;
+                    preparation.output = entry.output;
+                    return true;
+                }
+            }
+            return false;
+        };
+        if (kind == ConversionJob::VideoToSequence) {
+            preparation.input = JobJournal::inputFingerprint(settings.inputPath, QStringList());
+            if (!completeFromHistory()) preparation.estimate = OutputEstimator::estimateSequence(settings);
+            if (!promise.isCanceled()) promise.addResult(preparation);
+            return;
+        }
+
+        // Keep only this job's sequence
+        QStringList files = Converter::findImageFiles(settings.inputPath, [&promise]() { return promise.isCanceled(); });
+        if (!extension.isEmpty()) {
+            QStringList matching;
+            for (const QString &file : files) {
+                QFileInfo info(file);
+                QString framePrefix;
+                int number = 0;
+                int padding = 0;
+                if (info.suffix() == extension
+                    && Converter::parseFrameNumber(info.completeBaseName(), framePrefix, number, padding)
+                    && framePrefix == prefix) {
+                    matching.append(file);
+                }
+            }
+            files = matching;
+        }
+        if (promise.isCanceled()) return;
+        preparation.files = files;
+        preparation.input = JobJournal::inputFingerprint(settings.inputPath, files);
+        if (!completeFromHistory()) {
+            ConversionSettings withFiles = settings;
+            withFiles.imageFiles = files;
+            preparation.estimate = OutputEstimator::estimateVideo(withFiles);
+        }
+        if (!promise.isCanceled()) promise.addResult(preparation);
+    }));
+}
+
+void JobQueue::onJobPrepared(int id)
+{
+    int index = indexOf(id);
+    if (index < 0 || !workers.contains(id)) return;
+
+    QFutureWatcher<Preparation> *preparer = workers[id].preparer;
+    workers[id].preparer = nullptr;
+    preparer->deleteLater();
+
+    // cancelAll may have come after the worker finished but before this slot ran, and found nothing to cancel
+    if (workers[id].cancelRequested || preparer->isCanceled() || preparer->future().resultCount() == 0) {
+        onJobFinished(id, false, "Job cancelled before it started.");
+        return;
+    }
+    Preparation preparation = preparer->result();
+    if (trace) {
+        trace->span(TraceRecorder::FirstSlotTrack + workers[id].slot, "prepare", "scan", workers[id].listUs,
+                    {{"frames", preparation.files.size()}, {"estimatedBytes", preparation.estimate.bytes}});
+    }
+    workers[id].input = preparation.input;
+    if (preparation.completedBy > 0) {
+        workers[id].fromHistory = true;
+        jobList[index].fingerprint = preparation.output;
+        onJobFinished(id, true, QString("Output unchanged since job %1, skipped.").arg(preparation.completedBy));
+        return;
+    }
+    if (!admit(id, preparation.estimate)) return;
+
+    // The budget goes on a copy so the journaled settings still identify the job
+    const ConversionJob &job = jobList.at(index);
+    ConversionSettings settings = job.settings;
+    settings.threads = workers[id].threads;
+    if (job.kind == ConversionJob::VideoToSequence) {
+        workers[id].converter->convertVideoToSequence(settings);
+        return;
+    }
+    settings.imageFiles = preparation.files;
+    workers[id].converter->convertSequenceToVideo(settings);
+}
+
+bool JobQueue::admit(int id, const OutputEstimate &estimate)
+{
+    // A little room is always left for the system and for estimates that ran short
+    const qint64 headroom = 256LL * 1024 * 1024;
+
+    ConversionJob &job = jobList[indexOf(id)];
+    if (estimate.bytes < 0) {
+        emit logMessage(QString("Job %1: output size unknown (%2); starting without a disk space check.")
+                        .arg(id).arg(estimate.error));
+        return true;
+    }
+    QString volume;
+    qint64 available = OutputEstimator::availableBytes(job.settings.outputPath, volume);
+    if (available < 0) return true;
+
+    qint64 reserved = reservedBytes(volume, id);
+    QString figures = QString("needs about %1 (%2 trial frames scaled to %3), %4 free on %5, %6 reserved by running jobs")
+                      .arg(OutputEstimator::formatBytes(estimate.bytes)).arg(estimate.sampleFrames).arg(estimate.frames)
+                      .arg(OutputEstimator::formatBytes(available), volume, OutputEstimator::formatBytes(reserved));
+    if (estimate.bytes + reserved + headroom <= available) {
+        reservations.insert(id, {volume, estimate.bytes});
+        emit logMessage(QString("Job %1 %2.").arg(id).arg(figures));
+        return true;
+    }
+
+    if (reserved > 0 && estimate.bytes + headroom <= available) {
+        // It fits on its own; wait for the running jobs, whose reservations may prove generous
+        Worker worker = workers.take(id);
+        worker.converter->deleteLater();
+        activeIds.removeAll(id);
+        job.state = ConversionJob::Queued;
+        deferred.insert(id);
+        if (journal) journal->recordDefer(id);
+        emit logMessage(QString("Job %1 deferred until a running job finishes: %2.").arg(id).arg(figures));
+        emit queueChanged();
+        schedule();
+        return false;
+    }
+
+    onJobFinished(id, false, QString("Not enough disk space: %1.").arg(figures));
+    return false;
+}
+
+qint64 JobQueue::reservedBytes(const QString &volume, int exceptId) const
+{
+    // What running jobs have yet to write: their estimate less the part already done
+    qint64 total = 0;
+    for (auto it = reservations.cbegin(); it != reservations.cend(); ++it) {
+        if (it.key() == exceptId || it.value().volume != volume) continue;
+        int percent = workers.contains(it.key()) ? workers.value(it.key()).percent : 0;
+        total += it.value().bytes / 100 * (100 - percent);
+    }
+    return total;
+}
+
+void JobQueue::onJobFinished(int id, bool success, const QString &message)
+{
+    Worker worker = workers.take(id);
+    if (worker.converter) worker.converter->deleteLater();
+    if (worker.preparer) worker.preparer->deleteLater();
+    reservations.remove(id);
+    deferred.remove(id);
+    if (!deferred.isEmpty()) {
+        // That job's disk usage is now known rather than reserved; deferred jobs get another look
+        emit logMessage(QString("Re-checking %1 deferred job(s) for disk space.").arg(deferred.size()));
+        deferred.clear();
+    }
+
+    int index = indexOf(id);
+    if (index >= 0) {
+        ConversionJob &job = jobList[index];
+        job.state = success ? ConversionJob::Done : (worker.cancelRequested ? ConversionJob::Canceled : ConversionJob::Failed);
+        job.held = false;
+        job.message = message;
+        job.elapsedMs = worker.clock.isValid() ? worker.clock.elapsed() : 0;
+        job.pausedMs = worker.converter ? worker.converter->pausedMilliseconds() : 0;
+        if (journal) journal->recordFinish(job);
+        if (success && !worker.fromHistory) recordHistory(id, worker.input);
+        if (trace) {
+            trace->span(TraceRecorder::FirstSlotTrack + worker.slot, QString("job #%1 %2").arg(job.id).arg(job.label),
+                        "job", worker.startUs,
+                        {{"state", stateName(job.state)}, {"message", message}, {"pausedMs", job.pausedMs}});
+        }
+        emit logMessage(QString("Job %1 %2 after %3 s (%4 s paused): %5")
+                        .arg(job.id).arg(stateName(job.state).toLower())
+                        .arg(job.elapsedMs / 1000.0, 0, 'f', 1).arg(job.pausedMs / 1000.0, 0, 'f', 1)
+                        .arg(message));
+        emit jobFinished(job.id, success, message);
+    }
+    activeIds.removeAll(id);
+    compactJournalIfNeeded();
+    emit queueChanged();
+    schedule();
+}
@@ -0,0 +1,143 @@
+// jobqueue.h
+#ifndef JOBQUEUE_H
+#define JOBQUEUE_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QJsonObject>
+#include <memory>
+#include "converter.h"
+#include "outputestimator.h"
+
+struct ConversionJob {
+    enum Kind { SequenceToVideo, VideoToSequence };
+    enum State { Queued, Running, Paused, Done, Failed, Canceled };
+    enum Priority { Low = -1, Normal = 0, Urgent = 1 };
+
+    int id = 0;
+    Kind kind = SequenceToVideo;
+    int priority = Normal;
+    QString label; // shown in the queue list
+    ConversionSettings settings;
+    // Restricts a directory holding several sequences to one of them; empty takes every frame
+    QString sequencePrefix;
+    QString sequenceExtension;
+    State state = Queued;
+    bool held = false; // paused by the user, so never resumed automatically
+    QString message;
+
+    // Stats: wall time from start to finish, and the part of it spent paused
+    qint64 elapsedMs = 0;
+    qint64 pausedMs = 0;
+    int checkpoint = 0;       // last progress percentage written to the journal
+    QJsonObject fingerprint;  // output size/mtime, once measured after success
+};
+
+class JobJournal;
+class ConcurrencyController;
+class TraceRecorder;
+
+// Runs conversion jobs in priority order, each on a Converter of its own, up
+// to a number at once that is either fixed or set by a ConcurrencyController.
+// A job with a higher priority than one running preempts it when no slot is
+// free: the running ffmpeg is stopped with SIGSTOP, keeping its progress, and
+// is continued once nothing more urgent is left. Before a job runs, its output
+// size is estimated and checked against free space on the target volume less
+// what running jobs have reserved; a job that can't fit is deferred or refused.
+class JobQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JobQueue(QObject *parent = nullptr);
+    ~JobQueue();
+
+    // Replays the journal at path, re-queues interrupted jobs and logs every change from then on
+    void openJournal(const QString &path);
+    static QString defaultJournalPath();
+
+    // Jobs run at once when adaptive concurrency is off, and its ceiling when on
+    void setMaxRunning(int jobs);
+    void setAdaptiveConcurrency(bool enabled);
+    // Job spans go on one trace track per worker slot, queue waits as async spans
+    void setTraceRecorder(TraceRecorder *recorder);
+
+    int enqueue(const ConversionJob &job);
+    bool pauseJob(int id);
+    bool resumeJob(int id);
+    void cancelAll();
+    void clearFinished();
+    bool isRunning() const;
+    QList<ConversionJob> jobs() const;
+
+    static QString stateName(ConversionJob::State state);
+    static QString priorityName(int priority);
+
+signals:
+    void queueChanged();
+    void jobStarted(int id);
+    void jobProgress(int id, int percentage);
+    void jobFinished(int id, bool success, const QString &message);
+    void logMessage(const QString &message);
+
+private:
+    // Worker-thread results needed before a job may start
+    struct Preparation {
+        QStringList files; // sequence jobs: the frames to encode
+        OutputEstimate estimate;
+        QJsonObject input;  // fingerprint of the input, kept in the history on success
+        int completedBy = 0; // earlier job whose output is still exactly what this one would make
+        QJsonObject output;  // that output's fingerprint
+    };
+    struct Worker {
+        Converter *converter = nullptr;
+        QFutureWatcher<Preparation> *preparer = nullptr; // frame listing and size estimate before the job starts
+        QElapsedTimer clock;
+        bool cancelRequested = false;
+        int frames = 0;  // latest frame count, for the concurrency controller
+        int percent = 0; // latest progress, to shrink its disk reservation
+        int threads = 0; // ffmpeg thread budget it was started with
+        int slot = 0;    // trace track index, the lowest one free when the job started
+        QJsonObject input; // input fingerprint taken before the job ran
+        bool fromHistory = false;
+        qint64 startUs = -1;
+        qint64 listUs = -1;
+    };
+
+    void schedule();
+    void startJob(ConversionJob &job);
+    void onJobPrepared(int id);
+    bool admit(int id, const OutputEstimate &estimate);
+    qint64 reservedBytes(const QString &volume, int exceptId) const;
+    void onJobFinished(int id, bool success, const QString &message);
+    int indexOf(int id) const;
+    int runningLimit() const;
+    int leastUrgentActive() const;
+    bool preempt(int id, const QString &reason);
+    void recordHistory(int id, const QJsonObject &input);
+    void compactJournalIfNeeded();
+
+    QList<ConversionJob> jobList;
+    QHash<int, Worker> workers; // started jobs that haven't finished, running or paused
+    QList<int> activeIds;       // jobs currently allowed to run, in the order they got their slot
+    bool preemptPending;        // a job must be paused but isn't pausable yet; retried on progress
+    int maxRunning;
+    ConcurrencyController *controller;
+    TraceRecorder *trace;
+    QHash<int, qint64> queuedSince; // trace time each waiting job was queued
+
+    struct Reservation {
+        QString volume;
+        qint64 bytes = 0;
+    };
+    QHash<int, Reservation> reservations; // estimated output of admitted jobs, by job id
+    QSet<int> deferred;                   // didn't fit beside the running jobs; retried when one finishes
+    int nextId;
+    std::unique_ptr<JobJournal> journal;
+};
+
+#endif // JOBQUEUE_H
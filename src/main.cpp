@@ -3,9 +3,11 @@
 #include <QStyleFactory>
 #include <QDir>
 #include "mainwindow.h"
+#include "startuptrace.h"
 
 int main(int argc, char *argv[])
 {
+    StartupTrace::begin();
     QApplication app(argc, argv);
     
     // Set application properties
@@ -32,6 +34,7 @@ int main(int argc, char *argv[])
     darkPalette.setColor(QPalette::Highlight, QColor(42, 130, 218));
     darkPalette.setColor(QPalette::HighlightedText, Qt::black);
     app.setPalette(darkPalette);
+    StartupTrace::mark("application");
     
     MainWindow window;
     window.show();
@@ -6,24 +6,60 @@
 #include "droplineedit.h"
 #include "presetmanager.h"
 #include "editablecommanddialog.h"
+#include "codecregistry.h"
+#include "concurrencycontroller.h"
+#include "startuptrace.h"
+#include "thumbnailstrip.h"
+#include "framenaming.h"
 #include <QInputDialog>
+#include <QStandardItemModel>
+#include <QTreeWidgetItemIterator>
+#include <QHash>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QElapsedTimer>
+#include <QTimer>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
-    , converter(new Converter(this))
+    , converter(new Converter(this, false))
     , isConverting(false)
+    , sequenceScanner(new SequenceScanner(this))
+    , jobQueue(new JobQueue(this))
+    , treeScanStartUs(-1)
+    , scanWatcher(new QFutureWatcher<QStringList>(this))
+    , scanForPreview(false)
+    , scanForTranscode(false)
+    , scanStartUs(-1)
+    , ffmpegLookupWatcher(new QFutureWatcher<QString>(this))
+    , presetWatcher(new QFutureWatcher<QList<QPair<QString, ConversionSettings>>>(this))
+    , ffmpegLookupDone(false)
+    , startupReported(false)
 {
+    presetManager = new PresetManager(this);
     setupUI();
     connectSignals();
+    converter->setTrace(&traceRecorder, TraceRecorder::InteractiveTrack);
+    jobQueue->setTraceRecorder(&traceRecorder);
+    jobQueue->openJournal(JobQueue::defaultJournalPath()); // after connectSignals, so restores are logged
+    updateCodecChoices();
     setWindowTitle("Image Sequence Converter");
     setMinimumSize(600, 500);
     resize(700, 600);
-    presetManager = new PresetManager(this);
+
+    // The ffmpeg search stats several paths and the presets are read from disk; neither
+    // holds up the first paint, they fill in when they finish
+    ffmpegLookupWatcher->setFuture(QtConcurrent::run(&Converter::findFFmpegPath));
     refreshPresetList();
+    StartupTrace::mark("window constructed");
 }
 
 MainWindow::~MainWindow()
 {
+    if (thumbnailWatcher) {
+        // The worker polls for this, so a long keyframe extraction ends with the window
+        thumbnailWatcher->cancel();
+        thumbnailWatcher->waitForFinished();
+    }
 }
 
 void MainWindow::setupUI()
@@ -36,13 +72,20 @@ void MainWindow::setupUI()
     // Create tab widget
     tabWidget = new QTabWidget(this);
     setupSequenceToVideoTab();
-    setupVideoToSequenceTab();
+    videoToSeqTab = new QWidget(); // filled in by ensureVideoToSequenceTab
+    tabWidget->addTab(videoToSeqTab, "Video → Image Sequence");
+    setupBatchTab();
     mainLayout->addWidget(tabWidget);
     
     // Progress bar
+    QHBoxLayout *progressLayout = new QHBoxLayout();
     progressBar = new QProgressBar(this);
     progressBar->setVisible(false);
-    mainLayout->addWidget(progressBar);
+    progressLayout->addWidget(progressBar, 1);
+    pauseBtn = new QPushButton("Pause", this);
+    pauseBtn->setVisible(false);
+    progressLayout->addWidget(pauseBtn);
+    mainLayout->addLayout(progressLayout);
 
     // Preset controls
     QHBoxLayout *presetLayout = new QHBoxLayout();
@@ -114,16 +157,31 @@ void MainWindow::setupSequenceToVideoTab()
     QHBoxLayout *formatRow = new QHBoxLayout();
     formatRow->addWidget(new QLabel("Format:"));
     videoFormatCombo = new QComboBox(this);
-    videoFormatCombo->addItems({"MP4", "AVI", "MOV", "MKV", "WebM"});
+    videoFormatCombo->addItems(CodecRegistry::containerLabels());
     videoFormatCombo->setMaximumWidth(100);
     formatRow->addWidget(videoFormatCombo);
     
     formatRow->addSpacing(20);  // Add some space
     formatRow->addWidget(new QLabel("Codec:"));
     videoCodecCombo = new QComboBox(this);
-    videoCodecCombo->addItems({"H.264", "H.265", "VP9", "ProRes"});
+    videoCodecCombo->addItems(CodecRegistry::codecLabels());
     videoCodecCombo->setMaximumWidth(100);
     formatRow->addWidget(videoCodecCombo);
+    
+    formatRow->addSpacing(20);
+    formatRow->addWidget(new QLabel("Speed:"));
+    speedTierCombo = new QComboBox(this);
+    speedTierCombo->addItems({"Draft", "Balanced", "Archive"});
+    speedTierCombo->setCurrentText("Balanced");
+    speedTierCombo->setToolTip("Draft: fastest encoder settings\nBalanced: sensible defaults\nArchive: slowest, best compression");
+    speedTierCombo->setMaximumWidth(100);
+    formatRow->addWidget(speedTierCombo);
+    
+    formatRow->addSpacing(20);
+    formatRow->addWidget(new QLabel("Pixel Format:"));
+    pixelFormatCombo = new QComboBox(this);
+    pixelFormatCombo->setMaximumWidth(120);
+    formatRow->addWidget(pixelFormatCombo);
     formatRow->addStretch();  // Push everything to the left
     videoLayout->addLayout(formatRow);
     
@@ -178,8 +236,154 @@ void MainWindow::setupSequenceToVideoTab()
     resolutionRow->addStretch();
     videoLayout->addLayout(resolutionRow);
     
+    // Incremental encode row
+    QHBoxLayout *incrementalRow = new QHBoxLayout();
+    incrementalCheckBox = new QCheckBox("Incremental Re-encode", this);
+    incrementalCheckBox->setToolTip("Encode in segments and only re-encode segments whose frames changed");
+    incrementalRow->addWidget(incrementalCheckBox);
+    incrementalRow->addSpacing(20);
+    incrementalRow->addWidget(new QLabel("Segment Length:"));
+    segmentLengthSpinBox = new QSpinBox(this);
+    segmentLengthSpinBox->setRange(1, 10000);
+    segmentLengthSpinBox->setValue(240);
+    segmentLengthSpinBox->setSuffix(" frames");
+    segmentLengthSpinBox->setEnabled(false);
+    segmentLengthSpinBox->setMaximumWidth(120);
+    incrementalRow->addWidget(segmentLengthSpinBox);
+    incrementalRow->addStretch();
+    videoLayout->addLayout(incrementalRow);
+    
+    connect(incrementalCheckBox, &QCheckBox::toggled, segmentLengthSpinBox, &QSpinBox::setEnabled);
+    
+    // Streaming output row
+    QHBoxLayout *streamingRow = new QHBoxLayout();
+    streamingRow->addWidget(new QLabel("Streaming:"));
+    streamingModeCombo = new QComboBox(this);
+    streamingModeCombo->addItems({"None", "Fragmented MP4", "HLS", "DASH"});
+    streamingModeCombo->setToolTip("Write output that can be played while encoding is still running");
+    streamingModeCombo->setMaximumWidth(140);
+    streamingRow->addWidget(streamingModeCombo);
+    streamingRow->addSpacing(20);
+    streamingRow->addWidget(new QLabel("Segment Duration:"));
+    segmentDurationSpinBox = new QSpinBox(this);
+    segmentDurationSpinBox->setRange(1, 60);
+    segmentDurationSpinBox->setValue(4);
+    segmentDurationSpinBox->setSuffix(" s");
+    segmentDurationSpinBox->setEnabled(false);
+    segmentDurationSpinBox->setMaximumWidth(80);
+    streamingRow->addWidget(segmentDurationSpinBox);
+    streamingRow->addStretch();
+    videoLayout->addLayout(streamingRow);
+    
+    connect(streamingModeCombo, &QComboBox::currentTextChanged, [this](const QString &mode) {
+        segmentDurationSpinBox->setEnabled(mode != "None");
+    });
+    
+    // Follow mode row
+    QHBoxLayout *followRow = new QHBoxLayout();
+    followSequenceCheckBox = new QCheckBox("Follow Growing Sequence", this);
+    followSequenceCheckBox->setToolTip("Encode frames as the renderer writes them instead of waiting for the last frame");
+    followRow->addWidget(followSequenceCheckBox);
+    followRow->addSpacing(20);
+    followRow->addWidget(new QLabel("End After Idle:"));
+    followTimeoutSpinBox = new QSpinBox(this);
+    followTimeoutSpinBox->setRange(5, 86400);
+    followTimeoutSpinBox->setValue(120);
+    followTimeoutSpinBox->setSuffix(" s");
+    followTimeoutSpinBox->setEnabled(false);
+    followTimeoutSpinBox->setMaximumWidth(100);
+    followRow->addWidget(followTimeoutSpinBox);
+    followRow->addStretch();
+    videoLayout->addLayout(followRow);
+    
+    connect(followSequenceCheckBox, &QCheckBox::toggled, followTimeoutSpinBox, &QSpinBox::setEnabled);
+    
+    videoChecksumCheckBox = new QCheckBox("Write Checksum Manifest", this);
+    videoChecksumCheckBox->setToolTip("Record per-frame MD5 and stream SHA-256 during the encode in <output>.checksums.json");
+    videoLayout->addWidget(videoChecksumCheckBox);
+    
+    // Auto-tune row
+    QHBoxLayout *autoTuneRow = new QHBoxLayout();
+    autoTuneCheckBox = new QCheckBox("Auto-Tune Encoder", this);
+    autoTuneCheckBox->setToolTip("Trial-encode a few samples and pick the fastest preset/CRF that reaches the target SSIM");
+    autoTuneRow->addWidget(autoTuneCheckBox);
+    autoTuneRow->addSpacing(20);
+    autoTuneRow->addWidget(new QLabel("Target SSIM:"));
+    targetSsimSpinBox = new QDoubleSpinBox(this);
+    targetSsimSpinBox->setRange(0.80, 0.999);
+    targetSsimSpinBox->setDecimals(3);
+    targetSsimSpinBox->setSingleStep(0.005);
+    targetSsimSpinBox->setValue(0.98);
+    targetSsimSpinBox->setEnabled(false);
+    targetSsimSpinBox->setMaximumWidth(80);
+    autoTuneRow->addWidget(targetSsimSpinBox);
+    autoTuneRow->addStretch();
+    videoLayout->addLayout(autoTuneRow);
+    
+    connect(autoTuneCheckBox, &QCheckBox::toggled, targetSsimSpinBox, &QDoubleSpinBox::setEnabled);
+    
+    // Read-ahead row
+    QHBoxLayout *prefetchRow = new QHBoxLayout();
+    prefetchRow->addWidget(new QLabel("Read Ahead:"));
+    prefetchDepthSpinBox = new QSpinBox(this);
+    prefetchDepthSpinBox->setRange(0, 1000);
+    prefetchDepthSpinBox->setValue(0);
+    prefetchDepthSpinBox->setSpecialValueText("Off");
+    prefetchDepthSpinBox->setSuffix(" frames");
+    prefetchDepthSpinBox->setToolTip("Ask the OS to fetch this many frames ahead of the encoder; helps on network storage");
+    prefetchDepthSpinBox->setMaximumWidth(120);
+    prefetchRow->addWidget(prefetchDepthSpinBox);
+    prefetchRow->addStretch();
+    videoLayout->addLayout(prefetchRow);
+    
+    expandDuplicatesCheckBox = new QCheckBox("Restore Dropped Duplicate Frames", this);
+    expandDuplicatesCheckBox->setChecked(true);
+    expandDuplicatesCheckBox->setToolTip("When the directory has a dedup.json, repeat each frame for the duplicates it replaced so the video keeps its original length");
+    videoLayout->addWidget(expandDuplicatesCheckBox);
+    
     mainLayout->addWidget(videoGroup);
     
+    // Sequence to sequence: same input directory, frames rewritten in another format
+    QGroupBox *transcodeGroup = new QGroupBox("Convert Frames", this);
+    QVBoxLayout *transcodeLayout = new QVBoxLayout(transcodeGroup);
+    QHBoxLayout *transcodeFormatRow = new QHBoxLayout();
+    transcodeFormatRow->addWidget(new QLabel("Format:"));
+    transcodeFormatCombo = new QComboBox(this);
+    transcodeFormatCombo->addItems({"PNG", "JPEG", "TIFF", "BMP", "EXR"});
+    transcodeFormatCombo->setMaximumWidth(100);
+    transcodeFormatRow->addWidget(transcodeFormatCombo);
+    transcodeFormatRow->addWidget(new QLabel("Bit Depth:"));
+    bitDepthCombo = new QComboBox(this);
+    bitDepthCombo->addItems({"Source", "8-bit", "16-bit"});
+    bitDepthCombo->setToolTip("16-bit applies to PNG and TIFF; EXR is always written as float");
+    bitDepthCombo->setMaximumWidth(100);
+    transcodeFormatRow->addWidget(bitDepthCombo);
+    transcodeResizeCheckBox = new QCheckBox("Resize to Width/Height Above", this);
+    transcodeFormatRow->addWidget(transcodeResizeCheckBox);
+    transcodeFormatRow->addStretch();
+    transcodeLayout->addLayout(transcodeFormatRow);
+    QHBoxLayout *transcodeOutputRow = new QHBoxLayout();
+    transcodeOutputEdit = new DropLineEdit(this);
+    transcodeOutputEdit->setPlaceholderText("Output directory for the converted frames...");
+    transcodeOutputRow->addWidget(transcodeOutputEdit, 1);
+    QPushButton *transcodeBrowseBtn = new QPushButton("Browse...", this);
+    transcodeBrowseBtn->setMaximumWidth(80);
+    transcodeOutputRow->addWidget(transcodeBrowseBtn);
+    transcodeBtn = new QPushButton("Convert Frames", this);
+    transcodeBtn->setToolTip("Converts frames on one FFmpeg per core, keeping the numbering; "
+                             "frames already converted with these settings are skipped");
+    transcodeOutputRow->addWidget(transcodeBtn);
+    transcodeLayout->addLayout(transcodeOutputRow);
+    mainLayout->addWidget(transcodeGroup);
+    
+    connect(transcodeBrowseBtn, &QPushButton::clicked, [this]() {
+        QString dirName = QFileDialog::getExistingDirectory(this, "Select Output Directory",
+            QStandardPaths::writableLocation(QStandardPaths::PicturesLocation));
+        if (!dirName.isEmpty()) {
+            transcodeOutputEdit->setText(dirName);
+        }
+    });
+    
     // Convert button
     convertBtn = new QPushButton("Convert to Video", this);
     convertBtn->setMinimumHeight(40);
@@ -207,11 +411,19 @@ void MainWindow::setupSequenceToVideoTab()
     mainLayout->addStretch();
 }
 
+void MainWindow::ensureVideoToSequenceTab()
+{
+    if (convertVideoBtn) return;
+    QElapsedTimer timer;
+    timer.start();
+    setupVideoToSequenceTab();
+    connect(convertVideoBtn, &QPushButton::clicked, this, &MainWindow::startVideoToSequenceConversion);
+    connect(remuxBtn, &QPushButton::clicked, this, &MainWindow::startRemux);
+    traceRecorder.instant(TraceRecorder::InteractiveTrack, "build video tab", "ui", {{"ms", timer.elapsed()}});
+}
+
 void MainWindow::setupVideoToSequenceTab()
 {
-    videoToSeqTab = new QWidget();
-    tabWidget->addTab(videoToSeqTab, "Video → Image Sequence");
-    
     QVBoxLayout *mainLayout = new QVBoxLayout(videoToSeqTab);
     mainLayout->setContentsMargins(10, 10, 10, 10);
     mainLayout->setSpacing(10);
@@ -260,11 +472,101 @@ void MainWindow::setupVideoToSequenceTab()
     formatRow->addStretch();
     imageLayout->addLayout(formatRow);
     
+    // Naming row
+    QHBoxLayout *namingRow = new QHBoxLayout();
+    namingRow->addWidget(new QLabel("File Names:"));
+    nameTemplateEdit = new QLineEdit(this);
+    nameTemplateEdit->setText("frame_{frame}");
+    nameTemplateEdit->setToolTip("Must end with {frame}; {name} is the input video's name");
+    namingRow->addWidget(nameTemplateEdit, 1);
+    namingRow->addWidget(new QLabel("Digits:"));
+    framePaddingSpinBox = new QSpinBox(this);
+    framePaddingSpinBox->setRange(0, 12);
+    framePaddingSpinBox->setSpecialValueText("Auto");
+    framePaddingSpinBox->setToolTip("Auto uses enough digits for the frame count, at least 4");
+    framePaddingSpinBox->setMaximumWidth(80);
+    namingRow->addWidget(framePaddingSpinBox);
+    namingRow->addWidget(new QLabel("Frames per Folder:"));
+    shardSizeSpinBox = new QSpinBox(this);
+    shardSizeSpinBox->setRange(0, 1000000);
+    shardSizeSpinBox->setSingleStep(1000);
+    shardSizeSpinBox->setSpecialValueText("All in One");
+    shardSizeSpinBox->setToolTip("Split the frames into subdirectories named after their first frame; they read back as one sequence");
+    shardSizeSpinBox->setMaximumWidth(100);
+    namingRow->addWidget(shardSizeSpinBox);
+    imageLayout->addLayout(namingRow);
+    
     // Extract all frames checkbox
     extractAllFrames = new QCheckBox("Extract All Frames", this);
     extractAllFrames->setChecked(true);
     imageLayout->addWidget(extractAllFrames);
     
+    // Sampling row
+    QHBoxLayout *samplingRow = new QHBoxLayout();
+    samplingRow->addWidget(new QLabel("Frames:"));
+    samplingModeCombo = new QComboBox(this);
+    samplingModeCombo->addItem("All Frames", "All");
+    samplingModeCombo->addItem("Keyframes Only", "Keyframes");
+    samplingModeCombo->addItem("Every Nth Frame", "Every Nth");
+    samplingModeCombo->addItem("Evenly Spaced", "Evenly Spaced");
+    samplingModeCombo->setToolTip("Keyframes and widely spaced samples are found without decoding the frames in between; frames.json maps each file to its source frame");
+    samplingRow->addWidget(samplingModeCombo);
+    samplingRow->addWidget(new QLabel("N:"));
+    sampleIntervalSpinBox = new QSpinBox(this);
+    sampleIntervalSpinBox->setRange(2, 100000);
+    sampleIntervalSpinBox->setValue(10);
+    sampleIntervalSpinBox->setEnabled(false);
+    sampleIntervalSpinBox->setMaximumWidth(80);
+    samplingRow->addWidget(sampleIntervalSpinBox);
+    samplingRow->addWidget(new QLabel("Count:"));
+    sampleCountSpinBox = new QSpinBox(this);
+    sampleCountSpinBox->setRange(1, 100000);
+    sampleCountSpinBox->setValue(100);
+    sampleCountSpinBox->setEnabled(false);
+    sampleCountSpinBox->setMaximumWidth(80);
+    samplingRow->addWidget(sampleCountSpinBox);
+    samplingRow->addStretch();
+    imageLayout->addLayout(samplingRow);
+    connect(samplingModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this]() {
+        QString mode = samplingModeCombo->currentData().toString();
+        sampleIntervalSpinBox->setEnabled(mode == "Every Nth");
+        sampleCountSpinBox->setEnabled(mode == "Evenly Spaced");
+    });
+    
+    sequenceChecksumCheckBox = new QCheckBox("Write Checksum Manifest", this);
+    sequenceChecksumCheckBox->setToolTip("Record each frame's MD5 during extraction in checksums.json");
+    imageLayout->addWidget(sequenceChecksumCheckBox);
+    
+    frameArchiveCheckBox = new QCheckBox("Write Packed Frame Archive", this);
+    frameArchiveCheckBox->setToolTip("Append frames to a few large frames-NNN.pack files indexed by frames.idx instead of one file per frame (not EXR)");
+    imageLayout->addWidget(frameArchiveCheckBox);
+    
+    dedupFramesCheckBox = new QCheckBox("Drop Duplicate Frames", this);
+    dedupFramesCheckBox->setToolTip("Only write frames that differ from the previous one; dedup.json records which source frames each stands for");
+    imageLayout->addWidget(dedupFramesCheckBox);
+    
+    // Parallel encode row
+    QHBoxLayout *parallelRow = new QHBoxLayout();
+    parallelEncodeCheckBox = new QCheckBox("Encode Images in Parallel", this);
+    parallelEncodeCheckBox->setToolTip("FFmpeg only decodes; a pool of threads compresses and writes the images (not EXR)");
+    parallelRow->addWidget(parallelEncodeCheckBox);
+    parallelRow->addWidget(new QLabel("Threads:"));
+    encodeThreadsSpinBox = new QSpinBox(this);
+    encodeThreadsSpinBox->setRange(0, 256);
+    encodeThreadsSpinBox->setSpecialValueText("Auto");
+    encodeThreadsSpinBox->setMaximumWidth(80);
+    parallelRow->addWidget(encodeThreadsSpinBox);
+    parallelRow->addWidget(new QLabel("Compression:"));
+    compressionLevelSpinBox = new QSpinBox(this);
+    compressionLevelSpinBox->setRange(-1, 9);
+    compressionLevelSpinBox->setValue(-1);
+    compressionLevelSpinBox->setSpecialValueText("Default");
+    compressionLevelSpinBox->setToolTip("0 is fastest, 9 smallest (PNG deflate level; TIFF LZW above 0; JPEG quality drops 10 per step)");
+    compressionLevelSpinBox->setMaximumWidth(80);
+    parallelRow->addWidget(compressionLevelSpinBox);
+    parallelRow->addStretch();
+    imageLayout->addLayout(parallelRow);
+    
     // Frame range row
     QHBoxLayout *frameRangeRow = new QHBoxLayout();
     frameRangeRow->addWidget(new QLabel("Start Frame:"));
@@ -285,8 +587,29 @@ void MainWindow::setupVideoToSequenceTab()
     frameRangeRow->addStretch();
     imageLayout->addLayout(frameRangeRow);
     
+    // Keyframe thumbnails of the input video, for picking the range by eye
+    thumbnailStrip = new ThumbnailStrip(this);
+    imageLayout->addWidget(thumbnailStrip);
+    
     mainLayout->addWidget(imageGroup);
     
+    // Container change for the same input video; streams are copied when the codec fits
+    QGroupBox *remuxGroup = new QGroupBox("Change Container", this);
+    QHBoxLayout *remuxLayout = new QHBoxLayout(remuxGroup);
+    remuxLayout->addWidget(new QLabel("Format:"));
+    remuxFormatCombo = new QComboBox(this);
+    remuxFormatCombo->addItems(CodecRegistry::containerLabels());
+    remuxFormatCombo->setMaximumWidth(100);
+    remuxLayout->addWidget(remuxFormatCombo);
+    remuxOutputEdit = new DropLineEdit(this);
+    remuxOutputEdit->setPlaceholderText("Output video file...");
+    remuxLayout->addWidget(remuxOutputEdit, 1);
+    remuxBtn = new QPushButton("Remux", this);
+    remuxBtn->setToolTip("Copies the video without re-encoding when its codec fits the container; "
+                         "otherwise re-encodes with the codec and quality of the Image Sequence tab");
+    remuxLayout->addWidget(remuxBtn);
+    mainLayout->addWidget(remuxGroup);
+    
     // Convert button
     convertVideoBtn = new QPushButton("Convert to Image Sequence", this);
     convertVideoBtn->setMinimumHeight(40);
@@ -345,6 +668,196 @@ void MainWindow::setupVideoToSequenceTab()
         startFrameSpinBox->setEnabled(!checked);
         endFrameSpinBox->setEnabled(!checked);
     });
+
+    // Thumbnails follow the input once typing settles; the strip and the spin boxes mirror each other
+    thumbnailTimer = new QTimer(this);
+    thumbnailTimer->setSingleShot(true);
+    thumbnailTimer->setInterval(400);
+    thumbnailWatcher = new QFutureWatcher<ThumbnailSet>(this);
+    connect(videoInputEdit, &QLineEdit::textChanged, thumbnailTimer, QOverload<>::of(&QTimer::start));
+    connect(thumbnailTimer, &QTimer::timeout, this, &MainWindow::loadThumbnails);
+    connect(thumbnailWatcher, &QFutureWatcher<ThumbnailSet>::finished, this, &MainWindow::onThumbnailsReady);
+    auto selectRange = [this](int start, int end) {
+        extractAllFrames->setChecked(false);
+        startFrameSpinBox->setValue(start);
+        endFrameSpinBox->setValue(end);
+    };
+    connect(thumbnailStrip, &ThumbnailStrip::rangeSelected, this, selectRange);
+    connect(thumbnailStrip, &ThumbnailStrip::startFrameSelected, this, [this, selectRange](int frame) {
+        selectRange(frame, qMax(frame, endFrameSpinBox->value()));
+    });
+    connect(thumbnailStrip, &ThumbnailStrip::endFrameSelected, this, [this, selectRange](int frame) {
+        selectRange(qMin(frame, startFrameSpinBox->value()), frame);
+    });
+    auto showRange = [this]() {
+        thumbnailStrip->setRange(extractAllFrames->isChecked() ? -1 : startFrameSpinBox->value(), endFrameSpinBox->value());
+    };
+    connect(extractAllFrames, &QCheckBox::toggled, this, showRange);
+    connect(startFrameSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, showRange);
+    connect(endFrameSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, showRange);
+    showRange();
+}
+
+void MainWindow::loadThumbnails()
+{
+    QString path = videoInputEdit->text().trimmed();
+    if (path == thumbnailVideo) return;
+    thumbnailVideo = path;
+    thumbnailFrameCount = 0;
+    thumbnailWatcher->cancel(); // an earlier video's thumbnails are no longer wanted
+    if (!QFileInfo(path).isFile()) {
+        thumbnailStrip->clear();
+        return;
+    }
+    thumbnailStrip->clear("Reading keyframes...");
+    thumbnailWatcher->setFuture(QtConcurrent::run([path](QPromise<ThumbnailSet> &promise) {
+        ThumbnailSet set = ThumbnailCache::fetch(Converter::findFFmpegPath(), path,
+                                                 [&promise]() { return promise.isCanceled(); });
+        if (!promise.isCanceled()) {
+            promise.addResult(set);
+        }
+    }));
+}
+
+void MainWindow::onThumbnailsReady()
+{
+    if (thumbnailWatcher->isCanceled() || thumbnailWatcher->future().resultCount() == 0) return;
+    ThumbnailSet set = thumbnailWatcher->result();
+    if (!set.error.isEmpty()) {
+        thumbnailStrip->clear("No thumbnails: " + set.error);
+        return;
+    }
+    thumbnailStrip->setThumbnails(set);
+    thumbnailFrameCount = set.frameCount;
+    if (!set.fromCache) {
+        logOutput->append(QString("Cached %1 keyframe thumbnails of %2.").arg(set.images.size()).arg(QFileInfo(thumbnailVideo).fileName()));
+    }
+}
+
+void MainWindow::setupBatchTab()
+{
+    batchTab = new QWidget();
+    tabWidget->addTab(batchTab, "Batch");
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(batchTab);
+    mainLayout->setContentsMargins(10, 10, 10, 10);
+    mainLayout->setSpacing(10);
+
+    // Discovery
+    QGroupBox *scanGroup = new QGroupBox("Project Tree", this);
+    QVBoxLayout *scanLayout = new QVBoxLayout(scanGroup);
+
+    QHBoxLayout *rootLayout = new QHBoxLayout();
+    rootLayout->addWidget(new QLabel("Root:"));
+    batchRootEdit = new DropLineEdit(this);
+    batchRootEdit->setPlaceholderText("Select a project or shot directory...");
+    rootLayout->addWidget(batchRootEdit, 1);
+    QPushButton *rootBrowseBtn = new QPushButton("Browse...", this);
+    rootBrowseBtn->setMaximumWidth(80);
+    rootLayout->addWidget(rootBrowseBtn);
+    scanLayout->addLayout(rootLayout);
+
+    QHBoxLayout *scanOptionsLayout = new QHBoxLayout();
+    scanOptionsLayout->addWidget(new QLabel("Threads:"));
+    scanThreadsSpinBox = new QSpinBox(this);
+    scanThreadsSpinBox->setRange(1, 256);
+    scanThreadsSpinBox->setValue(SequenceScanner::defaultThreadCount());
+    scanThreadsSpinBox->setToolTip("Directories listed in parallel. Network shares benefit from many more than there are cores.");
+    scanOptionsLayout->addWidget(scanThreadsSpinBox);
+    latestVersionOnlyCheckBox = new QCheckBox("Latest version only", this);
+    latestVersionOnlyCheckBox->setChecked(true);
+    scanOptionsLayout->addWidget(latestVersionOnlyCheckBox);
+    scanOptionsLayout->addStretch();
+    scanTreeBtn = new QPushButton("Scan Tree", this);
+    scanOptionsLayout->addWidget(scanTreeBtn);
+    scanLayout->addLayout(scanOptionsLayout);
+
+    sequenceTree = new QTreeWidget(this);
+    sequenceTree->setHeaderLabels({"Shot / Version", "Sequence", "Frames"});
+    sequenceTree->setColumnWidth(0, 220);
+    scanLayout->addWidget(sequenceTree, 1);
+    mainLayout->addWidget(scanGroup, 1);
+
+    // Queueing
+    QGroupBox *queueGroup = new QGroupBox("Queue", this);
+    QVBoxLayout *queueLayout = new QVBoxLayout(queueGroup);
+
+    QHBoxLayout *presetLayout = new QHBoxLayout();
+    presetLayout->addWidget(new QLabel("Preset:"));
+    batchPresetCombo = new QComboBox(this);
+    batchPresetCombo->addItem("Current Settings"); // saved presets are added once they are read
+    presetLayout->addWidget(batchPresetCombo, 1);
+    presetLayout->addWidget(new QLabel("Priority:"));
+    batchPriorityCombo = new QComboBox(this);
+    batchPriorityCombo->addItem("Low", ConversionJob::Low);
+    batchPriorityCombo->addItem("Normal", ConversionJob::Normal);
+    batchPriorityCombo->addItem("Urgent", ConversionJob::Urgent);
+    batchPriorityCombo->setCurrentIndex(1);
+    batchPriorityCombo->setToolTip("Urgent jobs pause lower-priority encodes and resume them when done.");
+    presetLayout->addWidget(batchPriorityCombo);
+    queueLayout->addLayout(presetLayout);
+
+    QHBoxLayout *outputLayout = new QHBoxLayout();
+    outputLayout->addWidget(new QLabel("Output Directory:"));
+    batchOutputEdit = new DropLineEdit(this);
+    batchOutputEdit->setPlaceholderText("Videos are named <shot>_<version>...");
+    outputLayout->addWidget(batchOutputEdit, 1);
+    QPushButton *batchOutputBrowseBtn = new QPushButton("Browse...", this);
+    batchOutputBrowseBtn->setMaximumWidth(80);
+    outputLayout->addWidget(batchOutputBrowseBtn);
+    queueLayout->addLayout(outputLayout);
+
+    QHBoxLayout *concurrencyLayout = new QHBoxLayout();
+    concurrencyLayout->addWidget(new QLabel("Parallel jobs:"));
+    parallelJobsSpinBox = new QSpinBox(this);
+    parallelJobsSpinBox->setRange(1, 64);
+    parallelJobsSpinBox->setValue(1);
+    parallelJobsSpinBox->setToolTip("Jobs encoded at once; with adaptive concurrency, the most it may run.");
+    concurrencyLayout->addWidget(parallelJobsSpinBox);
+    adaptiveConcurrencyCheckBox = new QCheckBox("Adapt to CPU and I/O load", this);
+    adaptiveConcurrencyCheckBox->setToolTip("Adds jobs while cores are idle or waiting on I/O and backs off when that "
+                                            "doesn't raise total frames per second. Decisions are logged.");
+    adaptiveConcurrencyCheckBox->setEnabled(ConcurrencyController::isSupported());
+    concurrencyLayout->addWidget(adaptiveConcurrencyCheckBox);
+    concurrencyLayout->addStretch();
+    queueLayout->addLayout(concurrencyLayout);
+
+    QHBoxLayout *queueButtonLayout = new QHBoxLayout();
+    pauseJobBtn = new QPushButton("Pause Job", this);
+    resumeJobBtn = new QPushButton("Resume Job", this);
+    queueButtonLayout->addWidget(pauseJobBtn);
+    queueButtonLayout->addWidget(resumeJobBtn);
+    queueButtonLayout->addStretch();
+    recordTraceCheckBox = new QCheckBox("Record Timeline", this);
+    recordTraceCheckBox->setToolTip("Record queue, scan, spawn, first-frame, encode and finalize spans for every job");
+    queueButtonLayout->addWidget(recordTraceCheckBox);
+    exportTraceBtn = new QPushButton("Export Timeline...", this);
+    exportTraceBtn->setToolTip("Save the recorded spans as Chrome trace JSON, for ui.perfetto.dev or chrome://tracing");
+    queueButtonLayout->addWidget(exportTraceBtn);
+    cancelQueueBtn = new QPushButton("Cancel Queue", this);
+    queueSelectedBtn = new QPushButton("Queue Selected", this);
+    queueButtonLayout->addWidget(cancelQueueBtn);
+    queueButtonLayout->addWidget(queueSelectedBtn);
+    queueLayout->addLayout(queueButtonLayout);
+
+    jobListWidget = new QListWidget(this);
+    jobListWidget->setMaximumHeight(120);
+    queueLayout->addWidget(jobListWidget);
+    mainLayout->addWidget(queueGroup);
+
+    connect(rootBrowseBtn, &QPushButton::clicked, [this]() {
+        QString dirName = QFileDialog::getExistingDirectory(this, "Select Project Root", batchRootEdit->text());
+        if (!dirName.isEmpty()) {
+            batchRootEdit->setText(dirName);
+        }
+    });
+    connect(batchOutputBrowseBtn, &QPushButton::clicked, [this]() {
+        QString dirName = QFileDialog::getExistingDirectory(this, "Select Output Directory",
+            QStandardPaths::writableLocation(QStandardPaths::MoviesLocation));
+        if (!dirName.isEmpty()) {
+            batchOutputEdit->setText(dirName);
+        }
+    });
 }
 
 void MainWindow::connectSignals()
@@ -352,13 +865,84 @@ void MainWindow::connectSignals()
     connect(inputBrowseBtn, &QPushButton::clicked, this, &MainWindow::selectInputPath);
     connect(outputBrowseBtn, &QPushButton::clicked, this, &MainWindow::selectOutputPath);
     connect(convertBtn, &QPushButton::clicked, this, &MainWindow::startConversion);
-    connect(convertVideoBtn, &QPushButton::clicked, this, &MainWindow::startVideoToSequenceConversion);
+    connect(transcodeBtn, &QPushButton::clicked, this, &MainWindow::startSequenceTranscode);
     connect(previewCmdBtn, &QPushButton::clicked, this, &MainWindow::showFFmpegCommandPreview);
     connect(frameRateSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::updateFrameRateDisplay);
     connect(qualitySpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::updateQualityDisplay);
+    connect(videoFormatCombo, &QComboBox::currentTextChanged, this, &MainWindow::updateCodecChoices);
+    connect(videoCodecCombo, &QComboBox::currentTextChanged, this, &MainWindow::updateCodecChoices);
+    // A tuned or preset-loaded encoder preset outranks the tier, so it must not outlive the choices it was made for
+    auto dropEncoderPreset = [this]() {
+        if (encoderPreset.isEmpty()) return;
+        logOutput->append(QString("Encoder preset %1 dropped; the speed tier applies again.").arg(encoderPreset));
+        encoderPreset.clear();
+    };
+    connect(speedTierCombo, &QComboBox::currentTextChanged, this, dropEncoderPreset);
+    connect(videoCodecCombo, &QComboBox::currentTextChanged, this, dropEncoderPreset);
+    connect(autoTuneCheckBox, &QCheckBox::toggled, this, dropEncoderPreset);
+    connect(scanWatcher, &QFutureWatcher<QStringList>::finished, this, &MainWindow::onSequenceScanFinished);
+    connect(ffmpegLookupWatcher, &QFutureWatcher<QString>::finished, this, &MainWindow::onFFmpegLookupFinished);
+    connect(presetWatcher, &QFutureWatcher<QList<QPair<QString, ConversionSettings>>>::finished,
+            this, &MainWindow::onPresetsLoaded);
+    connect(tabWidget, &QTabWidget::currentChanged, this, [this](int index) {
+        if (tabWidget->widget(index) == videoToSeqTab) ensureVideoToSequenceTab();
+    });
     connect(converter, &Converter::progressChanged, this, &MainWindow::onConversionProgress);
     connect(converter, &Converter::finished, this, &MainWindow::onConversionFinished);
     connect(converter, &Converter::logMessage, [this](const QString &message) { logOutput->append(message); });
+    connect(converter, &Converter::encoderTuned, [this](const QString &preset, int quality) {
+        encoderPreset = preset;
+        qualitySpinBox->setValue(quality);
+        logOutput->append(QString("Encoder settings recorded: preset %1, CRF %2").arg(preset).arg(quality));
+    });
+    connect(converter, &Converter::segmentsAvailable, [this](int count, const QString &playlistPath) {
+        logOutput->append(QString("%1 segment(s) ready for playback: %2").arg(count).arg(playlistPath));
+    });
+    connect(scanTreeBtn, &QPushButton::clicked, this, &MainWindow::scanProjectTree);
+    connect(sequenceScanner, &SequenceScanner::progress, this, [this](int directories, int sequences) {
+        scanTreeBtn->setText(QString("Cancel (%1 dirs, %2 found)").arg(directories).arg(sequences));
+    });
+    connect(sequenceScanner, &SequenceScanner::finished, this, &MainWindow::onProjectTreeScanned);
+    connect(latestVersionOnlyCheckBox, &QCheckBox::toggled, this, &MainWindow::applyLatestVersionFilter);
+    connect(queueSelectedBtn, &QPushButton::clicked, this, &MainWindow::queueSelectedSequences);
+    connect(cancelQueueBtn, &QPushButton::clicked, jobQueue, &JobQueue::cancelAll);
+    connect(parallelJobsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), jobQueue, &JobQueue::setMaxRunning);
+    jobQueue->setMaxRunning(parallelJobsSpinBox->value());
+    connect(adaptiveConcurrencyCheckBox, &QCheckBox::toggled, jobQueue, &JobQueue::setAdaptiveConcurrency);
+    connect(recordTraceCheckBox, &QCheckBox::toggled, [this](bool checked) { traceRecorder.setEnabled(checked); });
+    connect(exportTraceBtn, &QPushButton::clicked, this, &MainWindow::exportTrace);
+    connect(jobQueue, &JobQueue::queueChanged, this, &MainWindow::refreshJobList);
+    connect(jobQueue, &JobQueue::jobProgress, this, [this](int id, int percentage) {
+        for (int i = 0; i < jobListWidget->count(); ++i) {
+            QListWidgetItem *item = jobListWidget->item(i);
+            if (item->data(Qt::UserRole).toInt() == id) {
+                item->setText(QString("#%1 [%2] Running %3%  %4").arg(id)
+                              .arg(item->data(Qt::UserRole + 2).toString()).arg(percentage)
+                              .arg(item->data(Qt::UserRole + 1).toString()));
+            }
+        }
+    });
+    connect(pauseJobBtn, &QPushButton::clicked, [this]() {
+        QListWidgetItem *item = jobListWidget->currentItem();
+        if (item && !jobQueue->pauseJob(item->data(Qt::UserRole).toInt())) {
+            logOutput->append("Only the running job can be paused, once its encode has started.");
+        }
+    });
+    connect(resumeJobBtn, &QPushButton::clicked, [this]() {
+        QListWidgetItem *item = jobListWidget->currentItem();
+        if (item) jobQueue->resumeJob(item->data(Qt::UserRole).toInt());
+    });
+    connect(pauseBtn, &QPushButton::clicked, [this]() {
+        if (converter->isPaused()) {
+            converter->resume();
+            pauseBtn->setText("Pause");
+        } else if (converter->pause()) {
+            pauseBtn->setText("Resume");
+        } else {
+            logOutput->append("Nothing to pause yet; the encoder hasn't started.");
+        }
+    });
+    connect(jobQueue, &JobQueue::logMessage, [this](const QString &message) { logOutput->append(message); });
     connect(savePresetBtn, &QPushButton::clicked, this, &MainWindow::saveCurrentPreset);
     connect(loadPresetBtn, &QPushButton::clicked, this, &MainWindow::loadSelectedPreset);
     connect(deletePresetBtn, &QPushButton::clicked, this, &MainWindow::deleteSelectedPreset);
@@ -379,7 +963,7 @@ void MainWindow::selectOutputPath()
     QString fileName = QFileDialog::getSaveFileName(this, 
         "Save Video As", 
         QStandardPaths::writableLocation(QStandardPaths::MoviesLocation) + "/output.mp4",
-        "Video Files (*.mp4 *.avi *.mov *.mkv *.webm)");
+        "Video Files (*.mp4 *.avi *.mov *.mkv *.webm);;Streaming Playlists (*.m3u8 *.mpd)");
     if (!fileName.isEmpty()) {
         outputPathEdit->setText(fileName);
     }
@@ -387,13 +971,18 @@ void MainWindow::selectOutputPath()
 
 void MainWindow::startConversion()
 {
+    waitForFFmpegLookup();
+    if (scanWatcher->isRunning()) {
+        scanWatcher->cancel();
+        return;
+    }
     if (isConverting) {
         converter->cancel();
         return;
     }
     QString inputPath = inputPathEdit->text();
     QString outputPath = outputPathEdit->text();
-    QString extension = "." + videoFormatCombo->currentText().toLower();
+    QString extension = "." + Converter::outputExtension(sequenceToVideoSettings());
     if (!outputPath.endsWith(extension, Qt::CaseInsensitive)) {
         outputPath += extension;
         outputPathEdit->setText(outputPath);
@@ -402,21 +991,117 @@ void MainWindow::startConversion()
         QMessageBox::warning(this, "Error", "Please select both input and output paths.");
         return;
     }
-    ConversionSettings settings;
-    settings.inputPath = inputPath;
-    settings.outputPath = outputPath;
-    settings.videoFormat = videoFormatCombo->currentText().toLower();
-    settings.videoCodec = videoCodecCombo->currentText();
-    settings.frameRate = frameRateSpinBox->value();
-    settings.quality = qualitySpinBox->value();
-    settings.width = widthSpinBox->value();
-    settings.height = heightSpinBox->value();
-    settings.maintainAspectRatio = maintainAspectRatio->isChecked();
+    ConversionSettings settings = sequenceToVideoSettings();
+    QString invalid = Converter::validateSettings(settings);
+    if (!invalid.isEmpty()) {
+        QMessageBox::warning(this, "Error", invalid);
+        return;
+    }
     logOutput->clear();
     progressBar->setVisible(true);
     progressBar->setValue(0);
+    pauseBtn->setVisible(true);
+    pauseBtn->setText("Pause");
     convertBtn->setText("Cancel");
     isConverting = true;
+    scanForTranscode = false;
+    startSequenceScan(settings, false);
+}
+
+void MainWindow::startSequenceTranscode()
+{
+    waitForFFmpegLookup();
+    if (scanWatcher->isRunning()) {
+        scanWatcher->cancel();
+        return;
+    }
+    if (isConverting) {
+        converter->cancel();
+        return;
+    }
+    QString inputPath = inputPathEdit->text();
+    QString outputPath = transcodeOutputEdit->text();
+    if (inputPath.isEmpty() || outputPath.isEmpty()) {
+        QMessageBox::warning(this, "Error", "Please select the input directory and an output directory for the frames.");
+        return;
+    }
+
+    ConversionSettings settings = sequenceToVideoSettings(); // input, size and aspect
+    settings.outputPath = outputPath;
+    settings.imageFormat = transcodeFormatCombo->currentText();
+    settings.bitDepth = bitDepthCombo->currentText();
+    if (!transcodeResizeCheckBox->isChecked()) {
+        settings.width = 0;
+        settings.height = 0;
+    }
+
+    logOutput->clear();
+    progressBar->setVisible(true);
+    progressBar->setValue(0);
+    transcodeBtn->setText("Cancel");
+    isConverting = true;
+    scanForTranscode = true;
+    startSequenceScan(settings, false);
+}
+
+void MainWindow::startSequenceScan(const ConversionSettings &settings, bool forPreview)
+{
+    pendingScanSettings = settings;
+    scanForPreview = forPreview;
+
+    // Busy indicator while the directory is listed; large network shares can take seconds
+    if (forPreview) {
+        QApplication::setOverrideCursor(Qt::BusyCursor);
+    } else {
+        progressBar->setRange(0, 0);
+        logOutput->append(QString("Scanning %1...").arg(settings.inputPath));
+    }
+
+    scanStartUs = traceRecorder.now();
+    QString directory = settings.inputPath;
+    scanWatcher->setFuture(QtConcurrent::run([directory](QPromise<QStringList> &promise) {
+        QStringList files = Converter::findImageFiles(directory, [&promise]() { return promise.isCanceled(); });
+        if (!promise.isCanceled()) {
+            promise.addResult(files);
+        }
+    }));
+}
+
+void MainWindow::onSequenceScanFinished()
+{
+    bool canceled = scanWatcher->isCanceled() || scanWatcher->future().resultCount() == 0;
+    ConversionSettings settings = pendingScanSettings;
+    if (!canceled) {
+        settings.imageFiles = scanWatcher->result();
+    }
+    traceRecorder.span(TraceRecorder::InteractiveTrack, "list frames", "scan", scanStartUs,
+                       {{"frames", settings.imageFiles.size()}, {"canceled", canceled}});
+
+    if (scanForPreview) {
+        QApplication::restoreOverrideCursor();
+        if (canceled) return;
+        QStringList args = converter->buildFFmpegArguments(settings, true);
+        QString command = converter->isFFmpegAvailable() ? converter->findFFmpegPath() + " " + args.join(" ") : "ffmpeg not found";
+        QMessageBox::information(this, "FFmpeg Command Preview", command);
+        return;
+    }
+
+    progressBar->setRange(0, 100);
+    if (canceled) {
+        logOutput->append("Directory scan cancelled.");
+        progressBar->setVisible(false);
+        pauseBtn->setVisible(false);
+        convertBtn->setText("Convert to Video");
+        transcodeBtn->setText("Convert Frames");
+        isConverting = false;
+        return;
+    }
+    logOutput->append(QString("Found %1 frames.").arg(settings.imageFiles.size()));
+    if (scanForTranscode) {
+        converter->convertSequenceToSequence(settings);
+        return;
+    }
+
     QStringList args = converter->buildFFmpegArguments(settings, true);
     EditableCommandDialog dlg(converter->findFFmpegPath() + " " + args.join(" "), this);
     if (dlg.exec() == QDialog::Accepted) {
@@ -428,6 +1113,7 @@ void MainWindow::startConversion()
 
 void MainWindow::startVideoToSequenceConversion()
 {
+    waitForFFmpegLookup();
     if (isConverting) {
         converter->cancel();
         return;
@@ -438,13 +1124,7 @@ void MainWindow::startVideoToSequenceConversion()
         QMessageBox::warning(this, "Error", "Please select both input video and output directory.");
         return;
     }
-    ConversionSettings settings;
-    settings.inputPath = inputVideo;
-    settings.outputPath = outputDir;
-    settings.imageFormat = imageFormatCombo->currentText();
-    settings.extractAllFrames = extractAllFrames->isChecked();
-    settings.startFrame = startFrameSpinBox->value();
-    settings.endFrame = endFrameSpinBox->value();
+    ConversionSettings settings = videoToSequenceSettings();
     QStringList args = converter->buildFFmpegArguments(settings, false);
     EditableCommandDialog dlg(converter->findFFmpegPath() + " " + args.join(" "), this);
     if (dlg.exec() == QDialog::Accepted) {
@@ -456,11 +1136,66 @@ void MainWindow::startVideoToSequenceConversion()
     logOutput->clear();
     progressBar->setVisible(true);
     progressBar->setValue(0);
+    pauseBtn->setVisible(true);
+    pauseBtn->setText("Pause");
     convertVideoBtn->setText("Cancel");
     isConverting = true;
     converter->convertVideoToSequence(settings);
 }
 
+void MainWindow::startRemux()
+{
+    waitForFFmpegLookup();
+    if (isConverting) {
+        converter->cancel();
+        return;
+    }
+    QString inputVideo = videoInputEdit->text();
+    QString outputPath = remuxOutputEdit->text();
+    if (inputVideo.isEmpty()) {
+        QMessageBox::warning(this, "Error", "Please select an input video.");
+        return;
+    }
+    const CodecRegistry::ContainerInfo *container = CodecRegistry::containerForName(remuxFormatCombo->currentText());
+    if (outputPath.isEmpty()) {
+        QFileInfo input(inputVideo);
+        outputPath = input.dir().absoluteFilePath(input.completeBaseName() + "_remux");
+    }
+    QString extension = QString(".") + container->extension;
+    if (!outputPath.endsWith(extension, Qt::CaseInsensitive)) {
+        outputPath += extension;
+    }
+    remuxOutputEdit->setText(outputPath);
+    if (QFileInfo(outputPath).absoluteFilePath() == QFileInfo(inputVideo).absoluteFilePath()) {
+        QMessageBox::warning(this, "Error", "The output would overwrite the input video.");
+        return;
+    }
+
+    ConversionSettings settings = sequenceToVideoSettings(); // codec and quality for the re-encode fallback
+    settings.inputPath = inputVideo;
+    settings.outputPath = outputPath;
+    settings.videoFormat = QString::fromLatin1(container->extension);
+    const CodecRegistry::CodecInfo *codec = CodecRegistry::codecForLabel(settings.videoCodec);
+    if (!codec || !CodecRegistry::isCompatible(*codec, *container)) {
+        for (const CodecRegistry::CodecInfo &candidate : CodecRegistry::codecs) {
+            if (CodecRegistry::isCompatible(candidate, *container)) {
+                settings.videoCodec = candidate.label;
+                break;
+            }
+        }
+    }
+    settings.pixelFormat.clear();
+
+    logOutput->clear();
+    progressBar->setVisible(true);
+    progressBar->setValue(0);
+    pauseBtn->setVisible(true);
+    pauseBtn->setText("Pause");
+    remuxBtn->setText("Cancel");
+    isConverting = true;
+    converter->convertVideoToVideo(settings);
+}
+
 void MainWindow::onConversionProgress(int percentage)
 {
     progressBar->setValue(percentage);
@@ -469,10 +1204,15 @@ void MainWindow::onConversionProgress(int percentage)
 void MainWindow::onConversionFinished(bool success, const QString &message)
 {
     progressBar->setVisible(false);
+    pauseBtn->setVisible(false);
     convertBtn->setText("Convert to Video");
     if (convertVideoBtn) {
         convertVideoBtn->setText("Convert to Image Sequence");
     }
+    if (remuxBtn) {
+        remuxBtn->setText("Remux");
+    }
+    transcodeBtn->setText("Convert Frames");
     isConverting = false;
     
     logOutput->append(message);
@@ -508,6 +1248,7 @@ void MainWindow::updateQualityDisplay(int value)
 
 void MainWindow::showFFmpegCommandPreview()
 {
+    waitForFFmpegLookup();
     QString inputPath = inputPathEdit->text();
     QString outputPath = outputPathEdit->text();
 
@@ -516,25 +1257,14 @@ void MainWindow::showFFmpegCommandPreview()
         return;
     }
 
-    ConversionSettings settings;
-    settings.inputPath = inputPath;
-    settings.outputPath = outputPath;
-    settings.videoFormat = videoFormatCombo->currentText().toLower();
-    settings.videoCodec = videoCodecCombo->currentText();
-    settings.frameRate = frameRateSpinBox->value();
-    settings.quality = qualitySpinBox->value();
-    settings.width = widthSpinBox->value();
-    settings.height = heightSpinBox->value();
-    settings.maintainAspectRatio = maintainAspectRatio->isChecked();
-
-    QStringList args = converter->buildFFmpegArguments(settings, true);
-    QString command = converter->isFFmpegAvailable() ? converter->findFFmpegPath() + " " + args.join(" ") : "ffmpeg not found";
+    if (scanWatcher->isRunning()) return;
 
-    QMessageBox::information(this, "FFmpeg Command Preview", command);
+    startSequenceScan(sequenceToVideoSettings(), true);
 }
 
 void MainWindow::showVideoToSequenceCommandPreview()
 {
+    waitForFFmpegLookup();
     QString inputVideo = videoInputEdit->text();
     QString outputDir = seqOutputEdit->text();
 
@@ -543,13 +1273,11 @@ void MainWindow::showVideoToSequenceCommandPreview()
         return;
     }
 
-    ConversionSettings settings;
-    settings.inputPath = inputVideo;
-    settings.outputPath = outputDir;
-    settings.imageFormat = imageFormatCombo->currentText();
-    settings.extractAllFrames = extractAllFrames->isChecked();
-    settings.startFrame = startFrameSpinBox->value();
-    settings.endFrame = endFrameSpinBox->value();
+    ConversionSettings settings = videoToSequenceSettings();
+    // Padded as the extraction will be; the whole video's length is known once its thumbnails are in
+    int frames = !settings.extractAllFrames ? settings.endFrame - settings.startFrame + 1
+                 : inputVideo.trimmed() == thumbnailVideo ? thumbnailFrameCount : 0;
+    settings.framePadding = FrameNaming(settings, frames).padding();
 
     QStringList args = converter->buildFFmpegArguments(settings, false);
     QString command = converter->isFFmpegAvailable() ? converter->findFFmpegPath() + " " + args.join(" ") : "ffmpeg not found";
@@ -558,10 +1286,61 @@ void MainWindow::showVideoToSequenceCommandPreview()
 }
 
 void MainWindow::refreshPresetList() {
+    // Read on a worker; a newer request replaces one still running
+    PresetManager *manager = presetManager;
+    presetWatcher->setFuture(QtConcurrent::run([manager]() { return manager->loadPresets(); }));
+}
+
+void MainWindow::onPresetsLoaded() {
+    if (presetWatcher->future().resultCount() == 0) return;
     presetSelector->clear();
-    auto presets = presetManager->loadPresets();
+    batchPresetCombo->clear();
+    batchPresetCombo->addItem("Current Settings");
+    auto presets = presetWatcher->result();
     for (const auto &pair : presets) {
         presetSelector->addItem(pair.first);
+        if (!pair.second.videoFormat.isEmpty() || !pair.second.videoCodec.isEmpty()) {
+            batchPresetCombo->addItem(pair.first);
+        }
+    }
+    StartupTrace::mark("presets loaded");
+    reportStartup();
+}
+
+void MainWindow::onFFmpegLookupFinished()
+{
+    if (ffmpegLookupDone) return; // already taken by waitForFFmpegLookup
+    ffmpegLookupDone = true;
+    converter->setFFmpegPath(ffmpegLookupWatcher->result());
+    StartupTrace::mark("ffmpeg found");
+    reportStartup();
+}
+
+void MainWindow::waitForFFmpegLookup()
+{
+    // A conversion started in the first moments after launch waits for the search instead of failing
+    if (ffmpegLookupDone) return;
+    ffmpegLookupWatcher->waitForFinished();
+    onFFmpegLookupFinished();
+}
+
+void MainWindow::paintEvent(QPaintEvent *event)
+{
+    QMainWindow::paintEvent(event);
+    if (StartupTrace::elapsed("first paint") < 0) {
+        StartupTrace::mark("first paint");
+        QTimer::singleShot(0, this, &MainWindow::reportStartup); // not from inside the paint
+    }
+}
+
+void MainWindow::reportStartup()
+{
+    if (startupReported || !StartupTrace::reached({"first paint", "ffmpeg found", "presets loaded"})) return;
+    startupReported = true;
+    logOutput->append(StartupTrace::summary());
+    QString error;
+    if (!StartupTrace::write(error)) {
+        logOutput->append(error);
     }
 }
 
@@ -570,28 +1349,15 @@ void MainWindow::saveCurrentPreset() {
     QString name = QInputDialog::getText(this, "Save Preset", "Enter preset name:", QLineEdit::Normal, "", &ok);
     if (!ok || name.isEmpty()) return;
     ConversionSettings s;
-    if (tabWidget->currentIndex() == 0) { // Sequence to Video
-        s.inputPath = inputPathEdit->text();
-        s.outputPath = outputPathEdit->text();
-        s.videoFormat = videoFormatCombo->currentText().toLower();
-        s.videoCodec = videoCodecCombo->currentText();
-        s.frameRate = frameRateSpinBox->value();
-        s.quality = qualitySpinBox->value();
-        s.width = widthSpinBox->value();
-        s.height = heightSpinBox->value();
-        s.maintainAspectRatio = maintainAspectRatio->isChecked();
+    if (tabWidget->currentIndex() != 1) { // Sequence to Video (the Batch tab uses these settings too)
+        s = sequenceToVideoSettings();
         // Clear video-to-sequence fields
         s.imageFormat = "";
         s.startFrame = 0;
         s.endFrame = 0;
         s.extractAllFrames = false;
     } else { // Video to Sequence
-        s.inputPath = videoInputEdit->text();
-        s.outputPath = seqOutputEdit->text();
-        s.imageFormat = imageFormatCombo->currentText();
-        s.startFrame = startFrameSpinBox->value();
-        s.endFrame = endFrameSpinBox->value();
-        s.extractAllFrames = extractAllFrames->isChecked();
+        s = videoToSequenceSettings();
         // Clear sequence-to-video fields
         s.videoFormat = "";
         s.videoCodec = "";
@@ -616,14 +1382,35 @@ void MainWindow::loadSelectedPreset() {
                 tabWidget->setCurrentIndex(0);
                 inputPathEdit->setText(s.inputPath);
                 outputPathEdit->setText(s.outputPath);
-                videoFormatCombo->setCurrentText(s.videoFormat);
+                // Presets store the lower-case format; map it back to the registry label
+                const CodecRegistry::ContainerInfo *container = CodecRegistry::containerForName(s.videoFormat);
+                if (container) videoFormatCombo->setCurrentText(container->label);
                 videoCodecCombo->setCurrentText(s.videoCodec);
+                QString invalid = Converter::validateSettings(s);
+                if (!invalid.isEmpty()) {
+                    logOutput->append(QString("Preset \"%1\" is not valid: %2").arg(name, invalid));
+                }
+                speedTierCombo->setCurrentText(s.speedTier);
+                pixelFormatCombo->setCurrentIndex(s.pixelFormat.isEmpty() ? 0 : qMax(0, pixelFormatCombo->findText(s.pixelFormat)));
                 frameRateSpinBox->setValue(s.frameRate);
                 qualitySpinBox->setValue(s.quality);
                 widthSpinBox->setValue(s.width);
                 heightSpinBox->setValue(s.height);
                 maintainAspectRatio->setChecked(s.maintainAspectRatio);
+                incrementalCheckBox->setChecked(s.incremental);
+                segmentLengthSpinBox->setValue(s.segmentLength);
+                streamingModeCombo->setCurrentText(s.streamingMode);
+                segmentDurationSpinBox->setValue(s.segmentDuration);
+                followSequenceCheckBox->setChecked(s.followSequence);
+                followTimeoutSpinBox->setValue(s.followTimeout);
+                videoChecksumCheckBox->setChecked(s.writeChecksums);
+                autoTuneCheckBox->setChecked(s.autoTune);
+                encoderPreset = s.encoderPreset; // after the controls whose changes clear it
+                targetSsimSpinBox->setValue(s.targetSsim);
+                prefetchDepthSpinBox->setValue(s.prefetchDepth);
+                expandDuplicatesCheckBox->setChecked(s.expandDuplicates);
             } else { // Video to Sequence
+                ensureVideoToSequenceTab();
                 tabWidget->setCurrentIndex(1);
                 videoInputEdit->setText(s.inputPath);
                 seqOutputEdit->setText(s.outputPath);
@@ -631,6 +1418,18 @@ void MainWindow::loadSelectedPreset() {
                 startFrameSpinBox->setValue(s.startFrame);
                 endFrameSpinBox->setValue(s.endFrame);
                 extractAllFrames->setChecked(s.extractAllFrames);
+                sequenceChecksumCheckBox->setChecked(s.writeChecksums);
+                parallelEncodeCheckBox->setChecked(s.parallelImageEncode);
+                encodeThreadsSpinBox->setValue(s.encodeThreads);
+                compressionLevelSpinBox->setValue(s.compressionLevel);
+                samplingModeCombo->setCurrentIndex(qMax(0, samplingModeCombo->findData(s.samplingMode)));
+                sampleIntervalSpinBox->setValue(s.sampleInterval);
+                sampleCountSpinBox->setValue(s.sampleCount);
+                frameArchiveCheckBox->setChecked(s.frameArchive);
+                nameTemplateEdit->setText(s.nameTemplate);
+                framePaddingSpinBox->setValue(s.framePadding);
+                shardSizeSpinBox->setValue(s.shardSize);
+                dedupFramesCheckBox->setChecked(s.dedupFrames);
             }
             break;
         }
@@ -646,6 +1445,264 @@ void MainWindow::deleteSelectedPreset() {
     }
 }
 
+ConversionSettings MainWindow::sequenceToVideoSettings() const
+{
+    ConversionSettings settings;
+    settings.inputPath = inputPathEdit->text();
+    settings.outputPath = outputPathEdit->text();
+    settings.videoFormat = videoFormatCombo->currentText().toLower();
+    settings.videoCodec = videoCodecCombo->currentText();
+    settings.speedTier = speedTierCombo->currentText();
+    settings.pixelFormat = pixelFormatCombo->currentIndex() > 0 ? pixelFormatCombo->currentText() : QString();
+    settings.frameRate = frameRateSpinBox->value();
+    settings.quality = qualitySpinBox->value();
+    settings.width = widthSpinBox->value();
+    settings.height = heightSpinBox->value();
+    settings.maintainAspectRatio = maintainAspectRatio->isChecked();
+    settings.incremental = incrementalCheckBox->isChecked();
+    settings.segmentLength = segmentLengthSpinBox->value();
+    settings.streamingMode = streamingModeCombo->currentText();
+    settings.segmentDuration = segmentDurationSpinBox->value();
+    settings.followSequence = followSequenceCheckBox->isChecked();
+    settings.followTimeout = followTimeoutSpinBox->value();
+    settings.writeChecksums = videoChecksumCheckBox->isChecked();
+    settings.encoderPreset = encoderPreset;
+    settings.autoTune = autoTuneCheckBox->isChecked();
+    settings.targetSsim = targetSsimSpinBox->value();
+    settings.prefetchDepth = prefetchDepthSpinBox->value();
+    settings.expandDuplicates = expandDuplicatesCheckBox->isChecked();
+    return settings;
+}
+
+ConversionSettings MainWindow::videoToSequenceSettings() const
+{
+    ConversionSettings settings;
+    settings.inputPath = videoInputEdit->text();
+    settings.outputPath = seqOutputEdit->text();
+    settings.imageFormat = imageFormatCombo->currentText();
+    settings.extractAllFrames = extractAllFrames->isChecked();
+    settings.startFrame = startFrameSpinBox->value();
+    settings.endFrame = endFrameSpinBox->value();
+    settings.writeChecksums = sequenceChecksumCheckBox->isChecked();
+    settings.parallelImageEncode = parallelEncodeCheckBox->isChecked();
+    settings.encodeThreads = encodeThreadsSpinBox->value();
+    settings.compressionLevel = compressionLevelSpinBox->value();
+    settings.samplingMode = samplingModeCombo->currentData().toString();
+    settings.sampleInterval = sampleIntervalSpinBox->value();
+    settings.sampleCount = sampleCountSpinBox->value();
+    settings.frameArchive = frameArchiveCheckBox->isChecked();
+    settings.nameTemplate = nameTemplateEdit->text().trimmed();
+    settings.framePadding = framePaddingSpinBox->value();
+    settings.shardSize = shardSizeSpinBox->value();
+    settings.dedupFrames = dedupFramesCheckBox->isChecked();
+    return settings;
+}
+
+void MainWindow::updateCodecChoices()
+{
+    const CodecRegistry::ContainerInfo *container = CodecRegistry::containerForName(videoFormatCombo->currentText());
+    QStandardItemModel *codecModel = qobject_cast<QStandardItemModel *>(videoCodecCombo->model());
+    if (!container || !codecModel) return;
+
+    // Grey out codecs the container can't hold, and move off one that just became illegal
+    int firstLegal = -1;
+    for (int i = 0; i < videoCodecCombo->count(); ++i) {
+        const CodecRegistry::CodecInfo *codec = CodecRegistry::codecForLabel(videoCodecCombo->itemText(i));
+        bool legal = codec && CodecRegistry::isCompatible(*codec, *container);
+        codecModel->item(i)->setEnabled(legal);
+        if (legal && firstLegal < 0) firstLegal = i;
+    }
+    QStandardItem *current = codecModel->item(videoCodecCombo->currentIndex());
+    if (current && !current->isEnabled() && firstLegal >= 0) {
+        videoCodecCombo->setCurrentIndex(firstLegal); // re-enters through currentTextChanged
+        return;
+    }
+
+    const CodecRegistry::CodecInfo *codec = CodecRegistry::codecForLabel(videoCodecCombo->currentText());
+    if (!codec) return;
+    QString previous = pixelFormatCombo->currentText();
+    pixelFormatCombo->blockSignals(true);
+    pixelFormatCombo->clear();
+    pixelFormatCombo->addItem(QString("Auto (%1)").arg(CodecRegistry::pixelFormatInfo(codec->defaultPixelFormat).name));
+    pixelFormatCombo->addItems(CodecRegistry::pixelFormatNames(*codec));
+    int index = pixelFormatCombo->findText(previous);
+    pixelFormatCombo->setCurrentIndex(index > 0 ? index : 0);
+    pixelFormatCombo->blockSignals(false);
+}
+
+void MainWindow::scanProjectTree()
+{
+    if (sequenceScanner->isScanning()) {
+        sequenceScanner->cancel();
+        return;
+    }
+    QString root = batchRootEdit->text();
+    if (root.isEmpty() || !QDir(root).exists()) {
+        QMessageBox::warning(this, "Error", "Please select an existing project directory.");
+        return;
+    }
+    sequenceTree->clear();
+    discoveredSequences.clear();
+    scanTreeBtn->setText("Cancel");
+    logOutput->append(QString("Scanning %1 with %2 threads...").arg(root).arg(scanThreadsSpinBox->value()));
+    treeScanStartUs = traceRecorder.now();
+    sequenceScanner->scan(root, scanThreadsSpinBox->value());
+}
+
+void MainWindow::onProjectTreeScanned(const QList<DiscoveredSequence> &sequences, bool canceled)
+{
+    scanTreeBtn->setText("Scan Tree");
+    traceRecorder.span(TraceRecorder::ScannerTrack, "scan tree", "scan", treeScanStartUs,
+                       {{"root", batchRootEdit->text()}, {"sequences", sequences.size()}, {"canceled", canceled}});
+    discoveredSequences = sequences;
+    logOutput->append(QString("%1 sequence(s) found%2.").arg(sequences.size()).arg(canceled ? " before the scan was cancelled" : ""));
+
+    // One top-level item per shot, one child per version/sequence
+    sequenceTree->clear();
+    QHash<QString, QTreeWidgetItem *> shots;
+    for (int i = 0; i < discoveredSequences.size(); ++i) {
+        const DiscoveredSequence &sequence = discoveredSequences.at(i);
+        QTreeWidgetItem *shotItem = shots.value(sequence.shot);
+        if (!shotItem) {
+            shotItem = new QTreeWidgetItem(sequenceTree, {sequence.shot});
+            shotItem->setFlags(shotItem->flags() | Qt::ItemIsAutoTristate | Qt::ItemIsUserCheckable);
+            shotItem->setCheckState(0, Qt::Checked);
+            shots.insert(sequence.shot, shotItem);
+        }
+        QString pattern = QString("%1%2.%3").arg(sequence.prefix, QString(sequence.padding, '#'), sequence.extension);
+        QTreeWidgetItem *item = new QTreeWidgetItem(shotItem, {
+            sequence.version.isEmpty() ? "(unversioned)" : sequence.version,
+            pattern,
+            QString("%1 (%2-%3)").arg(sequence.frameCount).arg(sequence.firstFrame).arg(sequence.lastFrame)});
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setData(0, Qt::UserRole, i);
+        item->setToolTip(1, sequence.directory);
+        item->setCheckState(0, Qt::Checked);
+    }
+    sequenceTree->sortItems(0, Qt::AscendingOrder);
+    applyLatestVersionFilter();
+}
+
+void MainWindow::applyLatestVersionFilter()
+{
+    bool latestOnly = latestVersionOnlyCheckBox->isChecked();
+    for (int s = 0; s < sequenceTree->topLevelItemCount(); ++s) {
+        QTreeWidgetItem *shotItem = sequenceTree->topLevelItem(s);
+        int latest = -1;
+        for (int c = 0; c < shotItem->childCount(); ++c) {
+            const DiscoveredSequence &sequence = discoveredSequences.at(shotItem->child(c)->data(0, Qt::UserRole).toInt());
+            latest = qMax(latest, sequence.version.mid(1).toInt());
+        }
+        for (int c = 0; c < shotItem->childCount(); ++c) {
+            QTreeWidgetItem *item = shotItem->child(c);
+            const DiscoveredSequence &sequence = discoveredSequences.at(item->data(0, Qt::UserRole).toInt());
+            bool keep = !latestOnly || sequence.version.isEmpty() || sequence.version.mid(1).toInt() == latest;
+            item->setCheckState(0, keep ? Qt::Checked : Qt::Unchecked);
+        }
+    }
+}
+
+void MainWindow::queueSelectedSequences()
+{
+    QString outputDir = batchOutputEdit->text();
+    if (outputDir.isEmpty()) {
+        QMessageBox::warning(this, "Error", "Please select an output directory.");
+        return;
+    }
+
+    ConversionSettings base = sequenceToVideoSettings();
+    if (batchPresetCombo->currentIndex() > 0) {
+        auto presets = presetManager->loadPresets();
+        for (const auto &pair : presets) {
+            if (pair.first == batchPresetCombo->currentText()) {
+                base = pair.second;
+                break;
+            }
+        }
+    }
+
+    // Directories holding more than one sequence need the prefix in the output name
+    QHash<QString, int> sequencesPerDirectory;
+    for (const DiscoveredSequence &sequence : discoveredSequences) {
+        sequencesPerDirectory[sequence.directory]++;
+    }
+
+    int queued = 0;
+    QTreeWidgetItemIterator it(sequenceTree, QTreeWidgetItemIterator::Checked | QTreeWidgetItemIterator::NoChildren);
+    for (; *it; ++it) {
+        const DiscoveredSequence &sequence = discoveredSequences.at((*it)->data(0, Qt::UserRole).toInt());
+
+        QString name = QString(sequence.shot).replace('/', '_');
+        if (!sequence.version.isEmpty()) name += "_" + sequence.version;
+        if (sequencesPerDirectory.value(sequence.directory) > 1) {
+            QString prefix = sequence.prefix;
+            while (prefix.endsWith('.') || prefix.endsWith('_') || prefix.endsWith('-')) prefix.chop(1);
+            name += "_" + (prefix.isEmpty() ? sequence.extension : prefix);
+        }
+
+        ConversionJob job;
+        job.kind = ConversionJob::SequenceToVideo;
+        job.settings = base;
+        job.settings.inputPath = sequence.directory;
+        job.settings.outputPath = QDir(outputDir).filePath(name + "." + Converter::outputExtension(base));
+        job.settings.followSequence = false;
+        job.settings.customCommand.clear();
+        job.sequencePrefix = sequence.prefix;
+        job.sequenceExtension = sequence.extension;
+        job.priority = batchPriorityCombo->currentData().toInt();
+        job.label = name;
+
+        QString invalid = Converter::validateSettings(job.settings);
+        if (!invalid.isEmpty()) {
+            logOutput->append(QString("Skipping %1: %2").arg(name, invalid));
+            continue;
+        }
+        jobQueue->enqueue(job);
+        queued++;
+    }
+    logOutput->append(QString("Queued %1 job(s).").arg(queued));
+}
+
+void MainWindow::refreshJobList()
+{
+    int selectedId = jobListWidget->currentItem() ? jobListWidget->currentItem()->data(Qt::UserRole).toInt() : -1;
+    jobListWidget->clear();
+    for (const ConversionJob &job : jobQueue->jobs()) {
+        QString priority = JobQueue::priorityName(job.priority);
+        QString text = QString("#%1 [%2] %3  %4").arg(job.id).arg(priority, JobQueue::stateName(job.state), job.label);
+        if (job.elapsedMs > 0) {
+            // Paused time is reported apart from the time spent encoding
+            text += QString("  (%1 s active, %2 s paused)")
+                    .arg((job.elapsedMs - job.pausedMs) / 1000.0, 0, 'f', 1).arg(job.pausedMs / 1000.0, 0, 'f', 1);
+        }
+        QListWidgetItem *item = new QListWidgetItem(text, jobListWidget);
+        item->setData(Qt::UserRole, job.id);
+        item->setData(Qt::UserRole + 1, job.label);
+        item->setData(Qt::UserRole + 2, priority);
+        if (!job.message.isEmpty()) item->setToolTip(job.message);
+        if (job.id == selectedId) jobListWidget->setCurrentItem(item);
+    }
+}
+
+void MainWindow::exportTrace()
+{
+    if (traceRecorder.eventCount() == 0) {
+        logOutput->append("Nothing recorded yet; tick Record Timeline before running jobs.");
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this, "Export Timeline",
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/conversion-trace.json",
+        "Chrome Trace (*.json)");
+    if (fileName.isEmpty()) return;
+    QString error;
+    if (!traceRecorder.exportTo(fileName, error)) {
+        QMessageBox::warning(this, "Error", error);
+        return;
+    }
+    logOutput->append(QString("Wrote %1 trace events to %2; open it in ui.perfetto.dev.")
+                      .arg(traceRecorder.eventCount()).arg(fileName));
+}
+
 void MainWindow::updateUIForMode()
 {
     // Future implementation for mode-specific UI updates
@@ -20,9 +20,19 @@
 #include <QTabWidget>
 #include <QCheckBox>
 #include <QSlider>
+#include <QFutureWatcher>
+#include <QTreeWidget>
+#include <QListWidget>
 #include "converter.h"
+#include "sequencescanner.h"
+#include "jobqueue.h"
+#include "tracerecorder.h"
 #include "presetmanager.h"
 #include "editablecommanddialog.h"
+#include "thumbnailcache.h"
+
+class ThumbnailStrip;
+class QTimer;
 
 class MainWindow : public QMainWindow
 {
@@ -42,27 +52,52 @@ private slots:
     void updateFrameRateDisplay(int value);
     void updateQualityDisplay(int value);
     void startVideoToSequenceConversion();
+    void startRemux();
+    void startSequenceTranscode();
     void showFFmpegCommandPreview();
     void showVideoToSequenceCommandPreview();
     void saveCurrentPreset();
     void loadSelectedPreset();
     void deleteSelectedPreset();
     void refreshPresetList();
+    void updateCodecChoices();
+    void onSequenceScanFinished();
+    void scanProjectTree();
+    void onProjectTreeScanned(const QList<DiscoveredSequence> &sequences, bool canceled);
+    void applyLatestVersionFilter();
+    void queueSelectedSequences();
+    void refreshJobList();
+    void exportTrace();
+    void onFFmpegLookupFinished();
+    void onPresetsLoaded();
+    void loadThumbnails();
+    void onThumbnailsReady();
+
 
 
+protected:
+    void paintEvent(QPaintEvent *event) override;
 
 private:
     void setupUI();
     void setupSequenceToVideoTab();
     void setupVideoToSequenceTab();
+    void ensureVideoToSequenceTab();
+    void waitForFFmpegLookup();
+    void reportStartup();
+    void setupBatchTab();
     void connectSignals();
     void updateUIForMode();
+    ConversionSettings sequenceToVideoSettings() const;
+    ConversionSettings videoToSequenceSettings() const;
+    void startSequenceScan(const ConversionSettings &settings, bool forPreview);
     
     // UI Components
     QWidget *centralWidget;
     QTabWidget *tabWidget;
     QWidget *seqToVideoTab;
     QWidget *videoToSeqTab;
+    QWidget *batchTab;
     
     // Common controls
     QLineEdit *inputPathEdit;
@@ -71,11 +106,14 @@ private:
     QPushButton *outputBrowseBtn;
     QPushButton *convertBtn;
     QProgressBar *progressBar;
+    QPushButton *pauseBtn;
     QTextEdit *logOutput;
     
     // Sequence to Video controls
     QComboBox *videoFormatCombo;
     QComboBox *videoCodecCombo;
+    QComboBox *speedTierCombo;
+    QComboBox *pixelFormatCombo;
     QSpinBox *frameRateSpinBox;
     QLabel *frameRateLabel;
     QSpinBox *qualitySpinBox;
@@ -83,17 +121,73 @@ private:
     QSpinBox *widthSpinBox;
     QSpinBox *heightSpinBox;
     QCheckBox *maintainAspectRatio;
-    
-    // Video to Sequence controls
-    QComboBox *imageFormatCombo;
-    QSpinBox *startFrameSpinBox;
-    QSpinBox *endFrameSpinBox;
-    QCheckBox *extractAllFrames;
-    QLineEdit *videoInputEdit;
-    QLineEdit *seqOutputEdit;
-    QPushButton *convertVideoBtn;
+    QCheckBox *incrementalCheckBox;
+    QSpinBox *segmentLengthSpinBox;
+    QComboBox *streamingModeCombo;
+    QSpinBox *segmentDurationSpinBox;
+    QCheckBox *followSequenceCheckBox;
+    QSpinBox *followTimeoutSpinBox;
+    QCheckBox *videoChecksumCheckBox;
+    QCheckBox *autoTuneCheckBox;
+    QDoubleSpinBox *targetSsimSpinBox;
+    QSpinBox *prefetchDepthSpinBox;
+    QCheckBox *expandDuplicatesCheckBox;
+    QString encoderPreset; // last auto-tuned or preset-loaded x264/x265 preset; cleared when tier, codec or auto-tune change
     QLineEdit *commandPreviewEdit;
     QPushButton *previewCmdBtn;
+    QComboBox *transcodeFormatCombo;
+    QComboBox *bitDepthCombo;
+    QCheckBox *transcodeResizeCheckBox;
+    QLineEdit *transcodeOutputEdit;
+    QPushButton *transcodeBtn;
+    
+    // Video to Sequence controls; the tab is built the first time it is shown, null until then
+    QComboBox *imageFormatCombo = nullptr;
+    QSpinBox *startFrameSpinBox = nullptr;
+    QSpinBox *endFrameSpinBox = nullptr;
+    QCheckBox *extractAllFrames = nullptr;
+    QCheckBox *sequenceChecksumCheckBox = nullptr;
+    QCheckBox *frameArchiveCheckBox = nullptr;
+    QCheckBox *dedupFramesCheckBox = nullptr;
+    QLineEdit *nameTemplateEdit = nullptr;
+    QSpinBox *framePaddingSpinBox = nullptr;
+    QSpinBox *shardSizeSpinBox = nullptr;
+    QCheckBox *parallelEncodeCheckBox = nullptr;
+    QSpinBox *encodeThreadsSpinBox = nullptr;
+    QSpinBox *compressionLevelSpinBox = nullptr;
+    QComboBox *samplingModeCombo = nullptr;
+    QSpinBox *sampleIntervalSpinBox = nullptr;
+    QSpinBox *sampleCountSpinBox = nullptr;
+    QLineEdit *videoInputEdit = nullptr;
+    QLineEdit *seqOutputEdit = nullptr;
+    QPushButton *convertVideoBtn = nullptr;
+    QComboBox *remuxFormatCombo = nullptr;
+    QLineEdit *remuxOutputEdit = nullptr;
+    QPushButton *remuxBtn = nullptr;
+    ThumbnailStrip *thumbnailStrip = nullptr;
+    QFutureWatcher<ThumbnailSet> *thumbnailWatcher = nullptr;
+    QTimer *thumbnailTimer = nullptr;
+    QString thumbnailVideo; // input the strip shows or is being made for
+    int thumbnailFrameCount = 0; // frames in thumbnailVideo as the thumbnails found, 0 until they are in
+
+    // Batch controls
+    QLineEdit *batchRootEdit;
+    QSpinBox *scanThreadsSpinBox;
+    QPushButton *scanTreeBtn;
+    QTreeWidget *sequenceTree;
+    QCheckBox *latestVersionOnlyCheckBox;
+    QComboBox *batchPresetCombo;
+    QComboBox *batchPriorityCombo;
+    QSpinBox *parallelJobsSpinBox;
+    QCheckBox *adaptiveConcurrencyCheckBox;
+    QLineEdit *batchOutputEdit;
+    QPushButton *queueSelectedBtn;
+    QPushButton *cancelQueueBtn;
+    QPushButton *pauseJobBtn;
+    QPushButton *resumeJobBtn;
+    QCheckBox *recordTraceCheckBox;
+    QPushButton *exportTraceBtn;
+    QListWidget *jobListWidget;
 
     // Preset controls
     QPushButton *savePresetBtn;
@@ -105,6 +199,24 @@ private:
     Converter *converter;
     PresetManager *presetManager;
     bool isConverting;
+    SequenceScanner *sequenceScanner;
+    JobQueue *jobQueue;
+    QList<DiscoveredSequence> discoveredSequences;
+    TraceRecorder traceRecorder;
+    qint64 treeScanStartUs;
+    
+    // Sequence discovery runs on a worker thread; these carry the request across
+    QFutureWatcher<QStringList> *scanWatcher;
+    ConversionSettings pendingScanSettings;
+    bool scanForPreview;
+    bool scanForTranscode; // the scanned frames go to convertSequenceToSequence
+    qint64 scanStartUs;
+
+    // Startup work that touches the disk runs after the first paint, on worker threads
+    QFutureWatcher<QString> *ffmpegLookupWatcher;
+    QFutureWatcher<QList<QPair<QString, ConversionSettings>>> *presetWatcher;
+    bool ffmpegLookupDone;
+    bool startupReported;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
@@ -0,0 +1,188 @@
+// outputestimator.cpp
+#include "outputestimator.h"
+#include "codecregistry.h"
+#include "videoprobe.h"
+#include "imageencodepool.h"
+#include <QImage>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QStorageInfo>
+#include <QDirIterator>
+
+namespace {
+
+const int VideoSampleFrames = 12;
+const int ImageSampleFrames = 5;
+const int TrialTimeoutMs = 60000;
+
+// Keyframes and container overhead make a short trial unrepresentative; err on the large side
+const double VideoMargin = 1.15;
+const double ImageMargin = 1.05;
+
+bool runTrial(const QString &ffmpegPath, const QStringList &args, QString &error, QByteArray *output = nullptr)
+{
+    QProcess process;
+    process.start(ffmpegPath, args);
+    if (!process.waitForFinished(TrialTimeoutMs) || process.exitStatus() != QProcess::NormalExit
+        || process.exitCode() != 0) {
+        process.kill();
+        QString messages = QString::fromUtf8(process.readAllStandardError()).trimmed();
+        error = QString("Trial encode failed: %1").arg(messages.section('\n', -1));
+        return false;
+    }
+    if (output) *output = process.readAllStandardOutput();
+    return true;
+}
+
+qint64 directorySize(const QString &path)
+{
+    qint64 bytes = 0;
+    QDirIterator it(path, QDir::Files);
+    while (it.hasNext()) {
+        it.next();
+        bytes += it.fileInfo().size();
+    }
+    return bytes;
+}
+
+} // namespace
+
+OutputEstimate OutputEstimator::estimateVideo(const ConversionSettings &settings)
+{
+    OutputEstimate estimate;
+    estimate.frames = settings.imageFiles.size();
+    if (estimate.frames == 0) {
+        estimate.error = "No frames to estimate from.";
+        return estimate;
+    }
+
+    // A private Converter only builds the arguments; it never runs anything
+    Converter builder;
+    QString ffmpeg = builder.findFFmpegPath();
+    QTemporaryDir scratch;
+    if (ffmpeg.isEmpty() || !scratch.isValid()) {
+        estimate.error = ffmpeg.isEmpty() ? "FFmpeg not found." : "No temporary directory for the trial encode.";
+        return estimate;
+    }
+
+    // Streaming output is estimated as the fMP4 it is segmented from
+    const CodecRegistry::ContainerInfo *container = CodecRegistry::containerForName(settings.videoFormat);
+    QString muxer = container && settings.streamingMode == "None" ? QString::fromLatin1(container->muxer) : QString("mp4");
+    QString trialFile = scratch.filePath("trial");
+
+    estimate.sampleFrames = qMin(VideoSampleFrames, estimate.frames);
+    int first = (estimate.frames - estimate.sampleFrames) / 2;
+    QStringList args;
+    args << builder.buildSequenceInputArguments(settings.imageFiles, first, estimate.sampleFrames, settings.frameRate);
+    if (Converter::canPassThroughJpeg(settings, settings.imageFiles)) {
+        args << "-c:v" << "copy";
+    } else {
+        args << builder.buildVideoEncodeArguments(settings);
+    }
+    args << "-an" << "-f" << muxer << "-y" << trialFile;
+
+    if (!runTrial(ffmpeg, args, estimate.error)) return estimate;
+    estimate.sampleBytes = QFileInfo(trialFile).size();
+    estimate.bytes = qint64(double(estimate.sampleBytes) / estimate.sampleFrames * estimate.frames * VideoMargin);
+    return estimate;
+}
+
+OutputEstimate OutputEstimator::estimateSequence(const ConversionSettings &settings)
+{
+    OutputEstimate estimate;
+    Converter builder;
+    QString ffmpeg = builder.findFFmpegPath();
+    QTemporaryDir scratch;
+    if (ffmpeg.isEmpty() || !scratch.isValid()) {
+        estimate.error = ffmpeg.isEmpty() ? "FFmpeg not found." : "No temporary directory for the trial encode.";
+        return estimate;
+    }
+
+    VideoInfo info;
+    if (!VideoProbe::probe(ffmpeg, settings.inputPath, info, estimate.error)) return estimate;
+    estimate.frames = settings.extractAllFrames ? info.frameCount : settings.endFrame - settings.startFrame + 1;
+    if (settings.samplingMode == "Every Nth") {
+        estimate.frames = (estimate.frames + qMax(1, settings.sampleInterval) - 1) / qMax(1, settings.sampleInterval);
+    } else if (settings.samplingMode == "Evenly Spaced") {
+        estimate.frames = qMin(estimate.frames, settings.sampleCount);
+    } else if (settings.samplingMode == "Keyframes") {
+        QList<double> keyframes;
+        if (!VideoProbe::keyframeTimes(ffmpeg, settings.inputPath, keyframes, estimate.error)) return estimate;
+        // Keyframes are spread roughly evenly, so a range holds its share of them
+        estimate.frames = qMax(1, int(qint64(keyframes.size()) * estimate.frames / qMax(1, info.frameCount)));
+    }
+    if (estimate.frames <= 0) {
+        estimate.error = "The video's frame count is unknown.";
+        return estimate;
+    }
+
+    // Frames from the middle of what is extracted are more typical than the opening titles
+    estimate.sampleFrames = qMin(ImageSampleFrames, estimate.frames);
+    double middle = info.duration / 2.0;
+    if (!settings.extractAllFrames && info.frameRate > 0) {
+        middle = (settings.startFrame + settings.endFrame + 1) / 2.0 / info.frameRate;
+    }
+    QStringList args;
+    args << "-ss" << QString::number(middle, 'f', 3);
+
+    // The same encoder the job will use: Qt's writers behind a raw decode, or ffmpeg's own
+    bool sampled = !settings.samplingMode.isEmpty() && settings.samplingMode != "All";
+    if (!sampled && (settings.parallelImageEncode || settings.frameArchive)
+        && ImageEncodePool::supportsFormat(settings.imageFormat)) {
+        args << "-noautorotate" << "-i" << settings.inputPath;
+        args << "-frames:v" << QString::number(estimate.sampleFrames);
+        args << "-an" << "-f" << "rawvideo" << "-pix_fmt" << "rgb24" << "-";
+        QByteArray raw;
+        if (!runTrial(ffmpeg, args, estimate.error, &raw)) return estimate;
+
+        QByteArray format = settings.imageFormat.toLower().toLatin1();
+        if (format == "jpeg") format = "jpg";
+        if (format == "tif") format = "tiff";
+        const qint64 frameBytes = qint64(info.width) * info.height * 3;
+        estimate.sampleFrames = int(raw.size() / frameBytes);
+        for (int i = 0; i < estimate.sampleFrames; ++i) {
+            QImage image(reinterpret_cast<const uchar *>(raw.constData() + i * frameBytes), info.width, info.height,
+                         info.width * 3, QImage::Format_RGB888);
+            QByteArray encoded;
+            if (!ImageEncodePool::encodeImage(image, format, settings.compressionLevel, encoded)) {
+                estimate.error = QString("Trial encode failed: cannot write %1 images.").arg(settings.imageFormat);
+                return estimate;
+            }
+            estimate.sampleBytes += encoded.size();
+        }
+    } else {
+        args << "-i" << settings.inputPath;
+        args << "-frames:v" << QString::number(estimate.sampleFrames);
+        args << "-an" << "-y" << scratch.filePath(QString("frame_%04d.%1").arg(settings.imageFormat.toLower()));
+        if (!runTrial(ffmpeg, args, estimate.error)) return estimate;
+        estimate.sampleBytes = directorySize(scratch.path());
+    }
+    if (estimate.sampleBytes <= 0) {
+        estimate.error = "The trial encode wrote no frames.";
+        return estimate;
+    }
+    estimate.bytes = qint64(double(estimate.sampleBytes) / estimate.sampleFrames * estimate.frames * ImageMargin);
+    return estimate;
+}
+
+qint64 OutputEstimator::availableBytes(const QString &outputPath, QString &volume)
+{
+    // The output (or its directory) may not exist yet; statvfs the nearest existing ancestor
+    QString path = QFileInfo(outputPath).absoluteFilePath();
+    while (!QFileInfo::exists(path)) {
+        QString parent = QFileInfo(path).absolutePath();
+        if (parent == path) break;
+        path = parent;
+    }
+    QStorageInfo storage(path);
+    if (!storage.isValid() || !storage.isReady()) return -1;
+    volume = storage.rootPath();
+    return storage.bytesAvailable();
+}
+
+QString OutputEstimator::formatBytes(qint64 bytes)
+{
+    const double gb = 1024.0 * 1024.0 * 1024.0;
+    if (bytes >= gb) return QString("%1 GB").arg(bytes / gb, 0, 'f', 1);
+    return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 0);
+}
@@ -0,0 +1,31 @@
+// outputestimator.h
+#ifndef OUTPUTESTIMATOR_H
+#define OUTPUTESTIMATOR_H
+
+#include <QString>
+#include "converter.h"
+
+struct OutputEstimate {
+    qint64 bytes = -1;     // projected output size, -1 when no estimate could be made
+    int frames = 0;        // frames the job will write or encode
+    int sampleFrames = 0;  // frames in the trial encode
+    qint64 sampleBytes = 0;
+    QString error;
+};
+
+// Predicts how much disk a job will use before it starts: a few frames from
+// the middle of the input (or of the selected range) are encoded with the
+// job's own settings and encoder, ffmpeg or the parallel image writer, and
+// their size is scaled by the frame count. Blocking; meant for worker threads.
+class OutputEstimator
+{
+public:
+    static OutputEstimate estimateVideo(const ConversionSettings &settings);    // sequence to video, imageFiles set
+    static OutputEstimate estimateSequence(const ConversionSettings &settings); // video to sequence
+
+    // Free bytes for an unprivileged user on the filesystem that will hold outputPath, -1 if unknown
+    static qint64 availableBytes(const QString &outputPath, QString &volume);
+    static QString formatBytes(qint64 bytes);
+};
+
+#endif // OUTPUTESTIMATOR_H
@@ -71,7 +71,7 @@ bool PresetManager::removePreset(const QString &name) {
     return true;
 }
 
-QJsonObject PresetManager::settingsToJson(const ConversionSettings &s) const {
+QJsonObject PresetManager::settingsToJson(const ConversionSettings &s) {
     QJsonObject o;
     o["inputPath"] = s.inputPath;
     o["outputPath"] = s.outputPath;
@@ -87,10 +87,35 @@ QJsonObject PresetManager::settingsToJson(const ConversionSettings &s) const {
     o["endFrame"] = s.endFrame;
     o["extractAllFrames"] = s.extractAllFrames;
     o["customCommand"] = s.customCommand;
+    o["incremental"] = s.incremental;
+    o["segmentLength"] = s.segmentLength;
+    o["streamingMode"] = s.streamingMode;
+    o["segmentDuration"] = s.segmentDuration;
+    o["followSequence"] = s.followSequence;
+    o["followTimeout"] = s.followTimeout;
+    o["writeChecksums"] = s.writeChecksums;
+    o["encoderPreset"] = s.encoderPreset;
+    o["autoTune"] = s.autoTune;
+    o["targetSsim"] = s.targetSsim;
+    o["speedTier"] = s.speedTier;
+    o["pixelFormat"] = s.pixelFormat;
+    o["parallelImageEncode"] = s.parallelImageEncode;
+    o["encodeThreads"] = s.encodeThreads;
+    o["compressionLevel"] = s.compressionLevel;
+    o["prefetchDepth"] = s.prefetchDepth;
+    o["samplingMode"] = s.samplingMode;
+    o["sampleInterval"] = s.sampleInterval;
+    o["sampleCount"] = s.sampleCount;
+    o["frameArchive"] = s.frameArchive;
+    o["nameTemplate"] = s.nameTemplate;
+    o["framePadding"] = s.framePadding;
+    o["shardSize"] = s.shardSize;
+    o["dedupFrames"] = s.dedupFrames;
+    o["expandDuplicates"] = s.expandDuplicates;
     return o;
 }
 
-ConversionSettings PresetManager::jsonToSettings(const QJsonObject &o) const {
+ConversionSettings PresetManager::jsonToSettings(const QJsonObject &o) {
     ConversionSettings s;
     s.inputPath = o["inputPath"].toString();
     s.outputPath = o["outputPath"].toString();
@@ -106,5 +131,30 @@ ConversionSettings PresetManager::jsonToSettings(const QJsonObject &o) const {
     s.endFrame = o["endFrame"].toInt();
     s.extractAllFrames = o["extractAllFrames"].toBool();
     s.customCommand = o["customCommand"].toString();
+    s.incremental = o["incremental"].toBool();
+    s.segmentLength = o["segmentLength"].toInt(240);
+    s.streamingMode = o["streamingMode"].toString("None");
+    s.segmentDuration = o["segmentDuration"].toInt(4);
+    s.followSequence = o["followSequence"].toBool();
+    s.followTimeout = o["followTimeout"].toInt(120);
+    s.writeChecksums = o["writeChecksums"].toBool();
+    s.encoderPreset = o["encoderPreset"].toString();
+    s.autoTune = o["autoTune"].toBool();
+    s.targetSsim = o["targetSsim"].toDouble(0.98);
+    s.speedTier = o["speedTier"].toString("Balanced");
+    s.pixelFormat = o["pixelFormat"].toString();
+    s.parallelImageEncode = o["parallelImageEncode"].toBool();
+    s.encodeThreads = o["encodeThreads"].toInt(0);
+    s.compressionLevel = o["compressionLevel"].toInt(-1);
+    s.prefetchDepth = o["prefetchDepth"].toInt(0);
+    s.samplingMode = o["samplingMode"].toString("All");
+    s.sampleInterval = o["sampleInterval"].toInt(10);
+    s.sampleCount = o["sampleCount"].toInt(100);
+    s.frameArchive = o["frameArchive"].toBool();
+    s.nameTemplate = o["nameTemplate"].toString("frame_{frame}");
+    s.framePadding = o["framePadding"].toInt(0);
+    s.shardSize = o["shardSize"].toInt(0);
+    s.dedupFrames = o["dedupFrames"].toBool();
+    s.expandDuplicates = o["expandDuplicates"].toBool(true);
     return s;
 }
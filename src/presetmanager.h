@@ -20,11 +20,13 @@ public:
     QList<QPair<QString, ConversionSettings>> loadPresets();
     bool removePreset(const QString &name);
 
+    // Also used by the job journal
+    static QJsonObject settingsToJson(const ConversionSettings &settings);
+    static ConversionSettings jsonToSettings(const QJsonObject &obj);
+
 private:
     QString presetFilePath() const;
     QString presetFolder() const;
-    QJsonObject settingsToJson(const ConversionSettings &settings) const;
-    ConversionSettings jsonToSettings(const QJsonObject &obj) const;
 };
 
 #endif // PRESETMANAGER_H
@@ -0,0 +1,296 @@
+// sequencescanner.cpp
+#include "sequencescanner.h"
+#include "converter.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QThread>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+struct SequenceScanner::State {
+    SequenceScanner *owner = nullptr;
+    QString root;
+    QThreadPool pool;
+    QMutex mutex;
+    QWaitCondition wake;
+    QStringList pending;
+    int busy = 0;        // workers currently reading a directory
+    int workersLeft = 0;
+    int scanned = 0;
+    QList<DiscoveredSequence> results;
+    QElapsedTimer sinceProgress;
+    std::atomic<bool> canceled{false};
+    std::atomic<bool> running{false};
+};
+
+namespace {
+
+struct DirectoryListing {
+    QStringList subdirectories;
+    QStringList files;
+};
+
+DirectoryListing readDirectory(const QString &path)
+{
+    DirectoryListing listing;
+#ifdef Q_OS_UNIX
+    // readdir() with d_type avoids a stat() round trip per entry, which dominates on NFS
+    DIR *dir = opendir(QFile::encodeName(path).constData());
+    if (!dir) return listing;
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;
+        QString name = QFile::decodeName(entry->d_name);
+
+        bool isDirectory = entry->d_type == DT_DIR;
+        bool isFile = entry->d_type == DT_REG;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+            struct stat info;
+            QByteArray fullPath = QFile::encodeName(path + '/' + name);
+            if (entry->d_type == DT_UNKNOWN && lstat(fullPath.constData(), &info) == 0) {
+                isDirectory = S_ISDIR(info.st_mode);
+                isFile = S_ISREG(info.st_mode);
+            } else if (entry->d_type == DT_LNK && stat(fullPath.constData(), &info) == 0) {
+                // Follow links to frames, but not to directories, which could form cycles
+                isFile = S_ISREG(info.st_mode);
+            }
+        }
+        if (isDirectory) listing.subdirectories.append(path + '/' + name);
+        else if (isFile) listing.files.append(name);
+    }
+    closedir(dir);
+#else
+    QDirIterator it(path, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    while (it.hasNext()) {
+        it.next();
+        if (it.fileInfo().isDir()) listing.subdirectories.append(it.filePath());
+        else listing.files.append(it.fileName());
+    }
+#endif
+    return listing;
+}
+
+bool isVersionFolder(const QString &name)
+{
+    if (name.length() < 2 || name.at(0).toLower() != 'v') return false;
+    for (int i = 1; i < name.length(); ++i) {
+        if (!name.at(i).isDigit()) return false;
+    }
+    return true;
+}
+
+// Splits off the version folder ("v003") so versions of a shot group together
+void locate(const QString &root, const QString &directory, QString &shot, QString &version)
+{
+    QStringList components = QDir(root).relativeFilePath(directory).split('/', Qt::SkipEmptyParts);
+    version.clear();
+    for (int i = components.size() - 1; i >= 0; --i) {
+        if (isVersionFolder(components.at(i))) {
+            version = components.takeAt(i);
+            break;
+        }
+    }
+    shot = components.isEmpty() || components == QStringList{"."} ? QDir(root).dirName() : components.join('/');
+}
+
+// Shards of an extraction are named after their first frame, with the frames' padding
+bool isShardOf(const QString &directory, const DiscoveredSequence &sequence)
+{
+    QString name = QFileInfo(directory).fileName();
+    bool numeric = false;
+    int first = name.toInt(&numeric);
+    return numeric && name.length() == sequence.padding && first == sequence.firstFrame;
+}
+
+QList<DiscoveredSequence> groupSequences(const QString &root, const QString &directory, const QStringList &files)
+{
+    static const QStringList extensions = Converter::imageExtensions();
+    QHash<QString, DiscoveredSequence> groups;
+
+    for (const QString &name : files) {
+        int dot = name.lastIndexOf('.');
+        if (dot <= 0) continue;
+        QString extension = name.mid(dot + 1);
+        if (!extensions.contains(extension.toLower())) continue;
+
+        QString prefix;
+        int number = 0;
+        int padding = 0;
+        if (!Converter::parseFrameNumber(name.left(dot), prefix, number, padding)) continue;
+
+        QString key = prefix + '\n' + extension + '\n' + QString::number(padding);
+        auto it = groups.find(key);
+        if (it == groups.end()) {
+            DiscoveredSequence sequence;
+            sequence.directory = directory;
+            sequence.prefix = prefix;
+            sequence.extension = extension;
+            sequence.padding = padding;
+            sequence.firstFrame = number;
+            sequence.lastFrame = number;
+            it = groups.insert(key, sequence);
+        }
+        it->firstFrame = qMin(it->firstFrame, number);
+        it->lastFrame = qMax(it->lastFrame, number);
+        it->frameCount++;
+    }
+
+    QString shot;
+    QString version;
+    locate(root, directory, shot, version);
+
+    QList<DiscoveredSequence> sequences;
+    for (DiscoveredSequence &sequence : groups) {
+        // A lone numbered file is not a sequence, unless it is the last shard's only frame
+        if (sequence.frameCount < 2 && !isShardOf(directory, sequence)) continue;
+        sequence.shot = shot;
+        sequence.version = version;
+        sequences.append(sequence);
+    }
+    return sequences;
+}
+
+// A sharded extraction lists as one sequence per subdirectory; fold them back into one
+void mergeShards(QList<DiscoveredSequence> &sequences, const QString &root)
+{
+    QList<DiscoveredSequence> merged;
+    QHash<QString, int> wholes; // parent, prefix, extension and padding -> index in merged
+    for (const DiscoveredSequence &sequence : sequences) {
+        if (sequence.directory == root || !isShardOf(sequence.directory, sequence)) {
+            merged.append(sequence);
+            continue;
+        }
+        QString parent = QFileInfo(sequence.directory).absolutePath();
+        QString key = parent + '\n' + sequence.prefix + '\n' + sequence.extension + '\n' + QString::number(sequence.padding);
+        auto it = wholes.constFind(key);
+        if (it == wholes.cend()) {
+            DiscoveredSequence whole = sequence;
+            whole.directory = parent;
+            locate(root, parent, whole.shot, whole.version);
+            wholes.insert(key, merged.size());
+            merged.append(whole);
+            continue;
+        }
+        DiscoveredSequence &whole = merged[*it];
+        whole.firstFrame = qMin(whole.firstFrame, sequence.firstFrame);
+        whole.lastFrame = qMax(whole.lastFrame, sequence.lastFrame);
+        whole.frameCount += sequence.frameCount;
+    }
+    sequences = merged;
+}
+
+} // namespace
+
+void SequenceScanner::runWorker(State *s)
+{
+    for (;;) {
+        QString directory;
+        {
+            QMutexLocker lock(&s->mutex);
+            while (s->pending.isEmpty() && s->busy > 0 && !s->canceled) {
+                s->wake.wait(&s->mutex);
+            }
+            if (s->pending.isEmpty() || s->canceled) {
+                s->wake.wakeAll();
+                break;
+            }
+            // Depth-first keeps the pending list short on wide trees
+            directory = s->pending.takeLast();
+            s->busy++;
+        }
+
+        DirectoryListing listing = readDirectory(directory);
+        QList<DiscoveredSequence> found = groupSequences(s->root, directory, listing.files);
+
+        QMutexLocker lock(&s->mutex);
+        s->pending += listing.subdirectories;
+        s->results += found;
+        s->busy--;
+        s->scanned++;
+        s->wake.wakeAll();
+        if (s->sinceProgress.elapsed() > 100) {
+            s->sinceProgress.restart();
+            emit s->owner->progress(s->scanned, s->results.size());
+        }
+    }
+
+    QMutexLocker lock(&s->mutex);
+    if (--s->workersLeft == 0) {
+        mergeShards(s->results, s->root);
+        std::sort(s->results.begin(), s->results.end(), [](const DiscoveredSequence &a, const DiscoveredSequence &b) {
+            return a.directory == b.directory ? a.prefix < b.prefix : a.directory < b.directory;
+        });
+        QList<DiscoveredSequence> results = s->results;
+        bool canceled = s->canceled;
+        int scanned = s->scanned;
+        s->running = false;
+        lock.unlock();
+        emit s->owner->progress(scanned, results.size());
+        emit s->owner->finished(results, canceled);
+    }
+}
+
+SequenceScanner::SequenceScanner(QObject *parent)
+    : QObject(parent)
+    , state(std::make_shared<State>())
+{
+    qRegisterMetaType<DiscoveredSequence>();
+    qRegisterMetaType<QList<DiscoveredSequence>>();
+    state->owner = this;
+}
+
+SequenceScanner::~SequenceScanner()
+{
+    cancel();
+    state->pool.waitForDone();
+}
+
+int SequenceScanner::defaultThreadCount()
+{
+    // Directory reads mostly wait on the server, so oversubscribe the cores
+    return qBound(8, QThread::idealThreadCount() * 4, 64);
+}
+
+bool SequenceScanner::isScanning() const
+{
+    return state->running;
+}
+
+void SequenceScanner::scan(const QString &root, int threads)
+{
+    if (state->running) return;
+
+    state->root = QDir(root).absolutePath();
+    state->pending = {state->root};
+    state->results.clear();
+    state->busy = 0;
+    state->scanned = 0;
+    state->canceled = false;
+    state->running = true;
+    state->sinceProgress.start();
+
+    threads = qMax(1, threads);
+    state->workersLeft = threads;
+    state->pool.setMaxThreadCount(threads);
+    State *s = state.get();
+    for (int i = 0; i < threads; ++i) {
+        state->pool.start([s]() { runWorker(s); });
+    }
+}
+
+void SequenceScanner::cancel()
+{
+    QMutexLocker lock(&state->mutex);
+    state->canceled = true;
+    state->wake.wakeAll();
+}
@@ -0,0 +1,54 @@
+// sequencescanner.h
+#ifndef SEQUENCESCANNER_H
+#define SEQUENCESCANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QMetaType>
+#include <atomic>
+#include <memory>
+
+struct DiscoveredSequence {
+    QString directory;  // absolute directory holding the frames
+    QString prefix;     // file name up to the frame number, e.g. "shot010_comp."
+    QString extension;
+    int padding = 0;
+    int firstFrame = 0;
+    int lastFrame = 0;
+    int frameCount = 0;
+    QString shot;       // directory relative to the root, with the version folder removed
+    QString version;    // "v012" style folder name, empty if unversioned
+};
+
+Q_DECLARE_METATYPE(DiscoveredSequence)
+
+// Walks a project tree with a pool of threads and reports every numbered
+// image sequence it finds. Directory reads are latency-bound on NFS, so many
+// more directories are kept in flight than there are cores.
+class SequenceScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SequenceScanner(QObject *parent = nullptr);
+    ~SequenceScanner();
+
+    void scan(const QString &root, int threads);
+    void cancel();
+    bool isScanning() const;
+
+    static int defaultThreadCount();
+
+signals:
+    void progress(int directoriesScanned, int sequencesFound);
+    void finished(const QList<DiscoveredSequence> &sequences, bool canceled);
+
+private:
+    struct State;
+    static void runWorker(State *state);
+
+    std::shared_ptr<State> state;
+};
+
+#endif // SEQUENCESCANNER_H
@@ -0,0 +1,252 @@
+// sequencetranscoder.cpp
+#include "sequencetranscoder.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+namespace {
+
+// Records the settings the outputs were made with; a change makes every frame stale
+const char *const StampName = ".transcode-settings";
+
+// Short enough to balance across workers, long enough to amortise the process start
+const int MaxRunLength = 64;
+
+QString patternFor(const QString &directory, QString prefix, int padding, const QString &extension)
+{
+    prefix.replace("%", "%%");
+    return QDir(directory).absoluteFilePath(prefix + "%0" + QString::number(padding) + "d." + extension);
+}
+
+} // namespace
+
+SequenceTranscoder::SequenceTranscoder(const QString &ffmpegPath, QObject *parent)
+    : QObject(parent)
+    , ffmpegPath(ffmpegPath)
+    , maxParallel(1)
+    , totalFrames(0)
+    , framesDone(0)
+    , stopped(false)
+{
+}
+
+SequenceTranscoder::~SequenceTranscoder()
+{
+    for (QProcess *process : running.keys()) {
+        process->disconnect(this);
+        process->kill();
+        process->waitForFinished(1000);
+    }
+}
+
+void SequenceTranscoder::start(const ConversionSettings &conversion, const QStringList &imageFiles)
+{
+    settings = conversion;
+    maxParallel = settings.encodeThreads > 0 ? settings.encodeThreads
+                  : settings.threads > 0 ? settings.threads : QThread::idealThreadCount();
+    maxParallel = qMax(1, maxParallel);
+
+    QString error;
+    if (!planRuns(imageFiles, error)) {
+        emit finished(false, error);
+        return;
+    }
+    int upToDate = imageFiles.size() - totalFrames;
+    if (totalFrames == 0) {
+        writeStamp();
+        emit progressChanged(100);
+        emit finished(true, QString("All %1 frames are already up to date.").arg(imageFiles.size()));
+        return;
+    }
+    emit logMessage(QString("Converting %1 frames (%2 already up to date) in %3 runs, %4 at a time...")
+                    .arg(totalFrames).arg(upToDate).arg(queue.size()).arg(maxParallel));
+    launchMore();
+}
+
+bool SequenceTranscoder::planRuns(const QStringList &imageFiles, QString &error)
+{
+    QDir outDir(settings.outputPath);
+    if (!outDir.mkpath(".")) {
+        error = QString("Failed to create output directory: %1").arg(settings.outputPath);
+        return false;
+    }
+
+    QString extension = settings.imageFormat.toLower();
+    stamp = QString("%1 %2x%3 %4 %5").arg(extension).arg(settings.width).arg(settings.height)
+            .arg(settings.maintainAspectRatio).arg(settings.bitDepth);
+    QFile stampFile(outDir.absoluteFilePath(StampName));
+    bool sameSettings = stampFile.open(QIODevice::ReadOnly) && QString::fromUtf8(stampFile.readAll()) == stamp;
+    stampFile.close();
+    // Until every frame is redone the directory holds no stamp, so an interrupted run
+    // leaves all frames stale rather than some made with the old settings looking current
+    if (!sameSettings && stampFile.exists() && !stampFile.remove()) {
+        error = QString("Cannot write to %1").arg(settings.outputPath);
+        return false;
+    }
+
+    // Stale frames that continue the previous one (same directory, name and padding) share a run
+    QList<Run> runs;
+    QString runKey;
+    int lastNumber = 0;
+    for (const QString &path : imageFiles) {
+        QFileInfo input(path);
+        QString prefix;
+        int number = 0;
+        int padding = 0;
+        if (!Converter::parseFrameNumber(input.completeBaseName(), prefix, number, padding)) {
+            error = QString("%1 has no frame number; only numbered sequences can be converted.").arg(input.fileName());
+            return false;
+        }
+        QString outputName = QString("%1%2.%3").arg(prefix, QString("%1").arg(number, padding, 10, QChar('0')), extension);
+        QFileInfo output(outDir.absoluteFilePath(outputName));
+        if (input.absoluteFilePath() == output.absoluteFilePath()) {
+            error = "The output would overwrite the input frames; choose another directory or format.";
+            return false;
+        }
+        if (sameSettings && output.exists() && output.lastModified() >= input.lastModified()) continue;
+
+        QString key = input.absolutePath() + '\n' + prefix + '\n' + input.suffix() + '\n' + QString::number(padding);
+        if (runs.isEmpty() || key != runKey || number != lastNumber + 1) {
+            Run run;
+            run.inputPattern = patternFor(input.absolutePath(), prefix, padding, input.suffix());
+            run.outputPattern = patternFor(settings.outputPath, prefix, padding, extension);
+            run.firstNumber = number;
+            runs.append(run);
+            runKey = key;
+        }
+        runs.last().count++;
+        runs.last().outputs.append(output.absoluteFilePath());
+        lastNumber = number;
+        totalFrames++;
+    }
+
+    // Split long runs so every worker has several to take
+    int runLength = qBound(1, totalFrames / (maxParallel * 4), MaxRunLength);
+    for (const Run &run : runs) {
+        for (int offset = 0; offset < run.count; offset += runLength) {
+            Run part = run;
+            part.firstNumber = run.firstNumber + offset;
+            part.count = qMin(runLength, run.count - offset);
+            part.outputs = run.outputs.mid(offset, part.count);
+            queue.append(part);
+        }
+    }
+    return true;
+}
+
+QStringList SequenceTranscoder::filterChain() const
+{
+    QStringList filters;
+    if (settings.width > 0 && settings.height > 0) {
+        filters << (settings.maintainAspectRatio
+                    ? QString("scale=%1:%2:force_original_aspect_ratio=decrease:flags=lanczos").arg(settings.width).arg(settings.height)
+                    : QString("scale=%1:%2:flags=lanczos").arg(settings.width).arg(settings.height));
+    }
+
+    // Offer the alpha and non-alpha layout of each depth; negotiation keeps alpha only where there is some
+    QString format = settings.imageFormat.toLower();
+    QString depth = settings.bitDepth;
+    if (format == "exr") {
+        filters << "format=gbrpf32le|gbrapf32le"; // the EXR writer is float only
+    } else if (depth == "16-bit" && format == "png") {
+        filters << "format=rgb48be|rgba64be";
+    } else if (depth == "16-bit" && (format == "tiff" || format == "tif")) {
+        filters << "format=rgb48le|rgba64le";
+    } else if (depth == "8-bit" || depth == "16-bit") {
+        // JPEG and BMP only hold 8 bits per channel
+        if (format == "png" || format == "tiff" || format == "tif") filters << "format=rgb24|rgba";
+        else if (format == "bmp") filters << "format=bgr24|bgra";
+    }
+    return filters;
+}
+
+void SequenceTranscoder::launchMore()
+{
+    while (!stopped && running.size() < maxParallel && !queue.isEmpty()) {
+        Run run = queue.takeFirst();
+        QStringList args;
+        args << "-hide_banner" << "-loglevel" << "error";
+        args << "-start_number" << QString::number(run.firstNumber) << "-i" << run.inputPattern;
+        args << "-frames:v" << QString::number(run.count);
+        QStringList filters = filterChain();
+        if (!filters.isEmpty()) args << "-vf" << filters.join(',');
+        QString format = settings.imageFormat.toLower();
+        if (format == "jpeg" || format == "jpg") args << "-q:v" << "2";
+        // Parallelism comes from the runs; one thread each keeps them from contending
+        args << "-threads" << "1" << "-filter_threads" << "1";
+        args << "-start_number" << QString::number(run.firstNumber) << "-y" << run.outputPattern;
+
+        QProcess *process = new QProcess(this);
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                this, &SequenceTranscoder::onRunFinished);
+        connect(process, &QProcess::errorOccurred, this, &SequenceTranscoder::onRunError);
+        running.insert(process, run);
+        process->start(ffmpegPath, args);
+    }
+}
+
+void SequenceTranscoder::onRunFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (!process || !running.contains(process)) return;
+    Run run = running.take(process);
+    QString output = QString::fromUtf8(process->readAllStandardError()).trimmed();
+    process->deleteLater();
+
+    if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+        for (const QString &path : run.outputs) QFile::remove(path);
+        stop(QString("Frames %1-%2 failed: %3").arg(run.firstNumber).arg(run.firstNumber + run.count - 1)
+             .arg(output.section('\n', -1)));
+        return;
+    }
+
+    framesDone += run.count;
+    emit frameProgress(framesDone);
+    emit progressChanged(framesDone * 100 / totalFrames);
+    if (queue.isEmpty() && running.isEmpty()) {
+        writeStamp();
+        emit finished(true, QString("Converted %1 frames to %2.").arg(framesDone).arg(settings.imageFormat));
+        return;
+    }
+    launchMore();
+}
+
+void SequenceTranscoder::onRunError(QProcess::ProcessError error)
+{
+    // finished() never comes for a process that did not start
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (error != QProcess::FailedToStart || !process || !running.contains(process)) return;
+    stop(QString("Cannot start FFmpeg (%1): %2").arg(ffmpegPath, process->errorString()));
+}
+
+void SequenceTranscoder::writeStamp()
+{
+    QFile stampFile(QDir(settings.outputPath).absoluteFilePath(StampName));
+    if (!stampFile.open(QIODevice::WriteOnly | QIODevice::Truncate) || stampFile.write(stamp.toUtf8()) < 0) {
+        emit logMessage(QString("Warning: cannot record the settings in %1; every frame will be redone next time.")
+                        .arg(stampFile.fileName()));
+    }
+}
+
+void SequenceTranscoder::cancel()
+{
+    stop("Conversion cancelled.");
+}
+
+void SequenceTranscoder::stop(const QString &message)
+{
+    if (stopped) return;
+    stopped = true;
+    queue.clear();
+    // Half-written frames would look up to date next time, so the runs in flight are discarded
+    for (auto it = running.begin(); it != running.end(); ++it) {
+        it.key()->disconnect(this);
+        it.key()->kill();
+        it.key()->waitForFinished(1000);
+        for (const QString &path : it.value().outputs) QFile::remove(path);
+        it.key()->deleteLater();
+    }
+    running.clear();
+    emit finished(false, message);
+}
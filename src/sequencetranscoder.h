@@ -0,0 +1,65 @@
+// sequencetranscoder.h
+#ifndef SEQUENCETRANSCODER_H
+#define SEQUENCETRANSCODER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include "converter.h"
+
+// Converts an image sequence into another image format, size or bit depth,
+// keeping the frame numbers. Frames whose output is newer than the input
+// (and was written with the same settings) are skipped. The rest are split
+// into short runs of consecutive frames, each converted by its own
+// single-threaded ffmpeg, with one process per core in flight, so the work
+// scales with cores and a process start is paid once per run, not per frame.
+class SequenceTranscoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    SequenceTranscoder(const QString &ffmpegPath, QObject *parent = nullptr);
+    ~SequenceTranscoder();
+
+    void start(const ConversionSettings &settings, const QStringList &imageFiles);
+    void cancel();
+
+signals:
+    void progressChanged(int percentage);
+    void frameProgress(int frames);
+    void logMessage(const QString &message);
+    void finished(bool success, const QString &message);
+
+private slots:
+    void onRunFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onRunError(QProcess::ProcessError error);
+
+private:
+    struct Run {
+        QString inputPattern;  // image2 patterns in and out
+        QString outputPattern;
+        int firstNumber = 0;
+        int count = 0;
+        QStringList outputs;   // removed if the run does not complete
+    };
+
+    bool planRuns(const QStringList &imageFiles, QString &error);
+    QStringList filterChain() const;
+    void launchMore();
+    void stop(const QString &message);
+    void writeStamp(); // only once every planned frame is converted
+
+    QString ffmpegPath;
+    ConversionSettings settings;
+    QString stamp;
+    QList<Run> queue;
+    QHash<QProcess *, Run> running;
+    int maxParallel;
+    int totalFrames;
+    int framesDone;
+    bool stopped;
+};
+
+#endif // SEQUENCETRANSCODER_H
@@ -0,0 +1,79 @@
+// startuptrace.cpp
+#include "startuptrace.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+
+namespace {
+
+QElapsedTimer startupClock;
+QDateTime startedAt;
+QList<QPair<QString, qint64>> marks; // in the order they were reached
+
+} // namespace
+
+void StartupTrace::begin()
+{
+    startupClock.start();
+    startedAt = QDateTime::currentDateTimeUtc();
+    marks.clear();
+}
+
+void StartupTrace::mark(const QString &name)
+{
+    if (!startupClock.isValid() || elapsed(name) >= 0) return;
+    marks.append({name, startupClock.elapsed()});
+}
+
+qint64 StartupTrace::elapsed(const QString &name)
+{
+    for (const auto &mark : marks) {
+        if (mark.first == name) return mark.second;
+    }
+    return -1;
+}
+
+bool StartupTrace::reached(const QStringList &names)
+{
+    for (const QString &name : names) {
+        if (elapsed(name) < 0) return false;
+    }
+    return true;
+}
+
+QString StartupTrace::summary()
+{
+    QStringList parts;
+    for (const auto &mark : marks) {
+        parts << QString("%1 %2 ms").arg(mark.first).arg(mark.second);
+    }
+    return "Startup: " + parts.join(", ");
+}
+
+bool StartupTrace::write(QString &error)
+{
+    QString path = qEnvironmentVariable(EnvironmentVariable);
+    if (path.isEmpty()) return true;
+
+    QJsonObject milestones;
+    for (const auto &mark : marks) {
+        milestones[mark.first] = mark.second;
+    }
+    QJsonObject launch{{"version", QCoreApplication::applicationVersion()},
+                       {"started", startedAt.toString(Qt::ISODateWithMs)},
+                       {"milliseconds", milestones}};
+
+    // One line per launch; a plain append keeps earlier launches intact
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)
+        || file.write(QJsonDocument(launch).toJson(QJsonDocument::Compact) + '\n') < 0) {
+        error = QString("Cannot write startup trace to %1").arg(path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+// startuptrace.h
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QString>
+#include <QStringList>
+
+// Milestones of application startup in milliseconds since main() began:
+// window constructed, first paint, and the deferred ffmpeg lookup and preset
+// load coming in. When ISC_STARTUP_TRACE names a file, each launch appends
+// one JSON line to it, so time to first paint can be compared across
+// releases. GUI thread only.
+class StartupTrace
+{
+public:
+    static constexpr const char *EnvironmentVariable = "ISC_STARTUP_TRACE";
+
+    static void begin();                    // first thing in main()
+    static void mark(const QString &name);  // only the first occurrence counts
+    static qint64 elapsed(const QString &name); // -1 until reached
+    static bool reached(const QStringList &names);
+
+    static QString summary();
+    // Appends the launch to the file in ISC_STARTUP_TRACE; true (and nothing written) when unset
+    static bool write(QString &error);
+};
+
+#endif // STARTUPTRACE_H
@@ -0,0 +1,170 @@
+// thumbnailcache.cpp
+#include "thumbnailcache.h"
+#include "videoprobe.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+
+namespace {
+
+const char *IndexName = "index.json";
+const int MaxThumbnails = 200;
+const int MaxCachedVideos = 64;
+const int PollMs = 200;
+
+QString cacheRoot()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+}
+
+QString thumbnailName(int index)
+{
+    return QString("thumb_%1.jpg").arg(index + 1, 4, 10, QChar('0')); // image2 counts from 1
+}
+
+// Drops the least recently made entries so the cache stays a few megabytes
+void pruneCache(const QString &keep)
+{
+    QFileInfoList entries = QDir(cacheRoot()).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Time);
+    for (int i = MaxCachedVideos; i < entries.size(); ++i) {
+        if (entries.at(i).absoluteFilePath() != keep) QDir(entries.at(i).absoluteFilePath()).removeRecursively();
+    }
+}
+
+} // namespace
+
+ThumbnailSet ThumbnailCache::fetch(const QString &ffmpegPath, const QString &videoPath,
+                                   const std::function<bool()> &isCanceled)
+{
+    ThumbnailSet set;
+    if (load(videoPath, set)) return set;
+    return build(ffmpegPath, videoPath, isCanceled);
+}
+
+QString ThumbnailCache::cacheDirectory(const QString &videoPath)
+{
+    QFileInfo info(videoPath);
+    if (!info.isFile() || !info.isReadable()) return QString();
+    // A changed file gets a new key, so stale thumbnails are never read
+    QByteArray key = info.absoluteFilePath().toUtf8() + '\n' + QByteArray::number(info.size()) + '\n'
+                     + QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+    return cacheRoot() + "/" + QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Md5).toHex());
+}
+
+bool ThumbnailCache::load(const QString &videoPath, ThumbnailSet &set)
+{
+    QString directory = cacheDirectory(videoPath);
+    if (directory.isEmpty()) return false;
+    QFile file(QDir(directory).absoluteFilePath(IndexName));
+    if (!file.open(QIODevice::ReadOnly)) return false; // the index is written last, so it marks a complete entry
+
+    QJsonObject index = QJsonDocument::fromJson(file.readAll()).object();
+    ThumbnailSet loaded;
+    loaded.frameCount = index["frameCount"].toInt();
+    loaded.frameRate = index["frameRate"].toDouble();
+    loaded.fromCache = true;
+    for (const QJsonValue &value : index["thumbnails"].toArray()) {
+        QJsonObject entry = value.toObject();
+        QImage image(QDir(directory).absoluteFilePath(entry["file"].toString()));
+        if (image.isNull()) return false;
+        loaded.frames << entry["frame"].toInt();
+        loaded.images << image;
+    }
+    if (loaded.images.isEmpty()) return false;
+    set = loaded;
+    return true;
+}
+
+ThumbnailSet ThumbnailCache::build(const QString &ffmpegPath, const QString &videoPath,
+                                   const std::function<bool()> &isCanceled)
+{
+    ThumbnailSet set;
+    QString directory = cacheDirectory(videoPath);
+    if (directory.isEmpty()) {
+        set.error = QString("Cannot read %1").arg(videoPath);
+        return set;
+    }
+    if (ffmpegPath.isEmpty()) {
+        set.error = "FFmpeg not found.";
+        return set;
+    }
+
+    VideoInfo info;
+    QList<double> keyframes;
+    if (!VideoProbe::probe(ffmpegPath, videoPath, info, set.error)
+        || !VideoProbe::keyframeTimes(ffmpegPath, videoPath, keyframes, set.error)) {
+        return set;
+    }
+    double fps = info.frameRate > 0 ? info.frameRate : 25.0;
+    if (isCanceled && isCanceled()) return set;
+
+    QDir dir(directory);
+    dir.removeRecursively();
+    if (!dir.mkpath(".")) {
+        set.error = QString("Cannot create thumbnail cache %1").arg(directory);
+        return set;
+    }
+
+    // The decoder skips everything but keyframes, so the select filter counts keyframes
+    int step = qMax(1, int((keyframes.size() + MaxThumbnails - 1) / MaxThumbnails));
+    QStringList args;
+    args << "-v" << "error" << "-skip_frame" << "nokey" << "-i" << videoPath << "-an";
+    args << "-vf" << QString("select=not(mod(n\\,%1)),scale=-2:%2").arg(step).arg(ThumbnailHeight);
+    args << "-fps_mode" << "passthrough" << "-q:v" << "5" << "-y"
+         << dir.absoluteFilePath("thumb_%04d.jpg");
+
+    QProcess process;
+    process.start(ffmpegPath, args);
+    while (!process.waitForFinished(PollMs)) {
+        if (process.state() == QProcess::NotRunning) break; // failed to start
+        if (isCanceled && isCanceled()) {
+            process.kill();
+            process.waitForFinished();
+            dir.removeRecursively();
+            set.error = "Cancelled.";
+            return set;
+        }
+    }
+    if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        dir.removeRecursively();
+        set.error = QString("Thumbnail extraction failed: %1")
+                    .arg(QString::fromUtf8(process.readAllStandardError()).trimmed().section('\n', -1));
+        return set;
+    }
+
+    // The n-th image is the n-th picked keyframe; ffprobe and the decoder see the same keyframes
+    QJsonArray entries;
+    for (int i = 0; i * step < keyframes.size(); ++i) {
+        QImage image(dir.absoluteFilePath(thumbnailName(i)));
+        if (image.isNull()) break;
+        double time = keyframes.at(i * step);
+        int frame = qRound(time * fps);
+        set.frames << frame;
+        set.images << image;
+        entries.append(QJsonObject{{"file", thumbnailName(i)}, {"frame", frame}, {"time", time}});
+    }
+    if (set.images.isEmpty()) {
+        dir.removeRecursively();
+        set.error = "FFmpeg produced no thumbnails.";
+        return set;
+    }
+    set.frameRate = fps;
+    set.frameCount = qMax(info.frameCount, set.frames.last() + 1);
+
+    QJsonObject index{{"source", QFileInfo(videoPath).absoluteFilePath()}, {"frameRate", fps},
+                      {"frameCount", set.frameCount}, {"thumbnails", entries}};
+    QSaveFile file(dir.absoluteFilePath(IndexName));
+    if (file.open(QIODevice::WriteOnly) && file.write(QJsonDocument(index).toJson()) >= 0) {
+        file.commit(); // without the index the entry is simply rebuilt next time
+    }
+    pruneCache(directory);
+    return set;
+}
@@ -0,0 +1,40 @@
+// thumbnailcache.h
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QString>
+#include <QList>
+#include <QImage>
+#include <functional>
+
+struct ThumbnailSet {
+    QList<int> frames;     // source frame of each thumbnail, ascending
+    QList<QImage> images;
+    int frameCount = 0;
+    double frameRate = 0.0;
+    bool fromCache = false;
+    QString error;
+};
+
+// Low-resolution keyframe thumbnails of a video for picking frame ranges.
+// Only keyframes are decoded (at most a couple of hundred, evenly picked), so
+// a long film takes seconds. Results are cached under the user's cache
+// directory, keyed by the video's path, size and modification time, so
+// reopening an unchanged file only reads a few small JPEGs. Blocking; meant
+// for worker threads.
+class ThumbnailCache
+{
+public:
+    static constexpr int ThumbnailHeight = 64;
+
+    // Cached thumbnails if the video is unchanged since they were made, otherwise new ones
+    static ThumbnailSet fetch(const QString &ffmpegPath, const QString &videoPath,
+                              const std::function<bool()> &isCanceled = nullptr);
+
+    static QString cacheDirectory(const QString &videoPath); // empty if the video cannot be read
+    static bool load(const QString &videoPath, ThumbnailSet &set);
+    static ThumbnailSet build(const QString &ffmpegPath, const QString &videoPath,
+                              const std::function<bool()> &isCanceled = nullptr);
+};
+
+#endif // THUMBNAILCACHE_H
@@ -0,0 +1,159 @@
+// thumbnailstrip.cpp
+#include "thumbnailstrip.h"
+#include <QPainter>
+#include <QMouseEvent>
+
+ThumbnailStrip::ThumbnailStrip(QWidget *parent)
+    : QWidget(parent)
+    , frameCount(0)
+    , frameRate(0.0)
+    , rangeStart(-1)
+    , rangeEnd(-1)
+    , hoverFrame(-1)
+    , anchorFrame(-1)
+    , dragging(false)
+{
+    setMouseTracking(true);
+    setFixedHeight(ThumbnailCache::ThumbnailHeight);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    setToolTip("Click to set the first frame, right-click or shift-click to set the last, or drag across a range");
+}
+
+void ThumbnailStrip::setThumbnails(const ThumbnailSet &set)
+{
+    pixmaps.clear();
+    for (const QImage &image : set.images) {
+        pixmaps << QPixmap::fromImage(image);
+    }
+    frames = set.frames;
+    frameRate = set.frameRate;
+    frameCount = qMax(set.frameCount, frames.isEmpty() ? 0 : frames.last() + 1);
+    message.clear();
+    update();
+}
+
+void ThumbnailStrip::clear(const QString &text)
+{
+    pixmaps.clear();
+    frames.clear();
+    frameCount = 0;
+    hoverFrame = -1;
+    anchorFrame = -1;
+    message = text;
+    update();
+}
+
+void ThumbnailStrip::setRange(int start, int end)
+{
+    rangeStart = start;
+    rangeEnd = qMax(start, end);
+    update();
+}
+
+QSize ThumbnailStrip::sizeHint() const
+{
+    return QSize(400, ThumbnailCache::ThumbnailHeight);
+}
+
+int ThumbnailStrip::frameAt(int x) const
+{
+    if (frameCount <= 0 || width() <= 0) return -1;
+    return qBound(0, int(qint64(x) * frameCount / width()), frameCount - 1);
+}
+
+int ThumbnailStrip::xForFrame(int frame) const
+{
+    return frameCount > 0 ? int(qint64(frame) * width() / frameCount) : 0;
+}
+
+void ThumbnailStrip::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+
+    if (pixmaps.isEmpty()) {
+        painter.setPen(palette().color(QPalette::PlaceholderText));
+        painter.drawText(rect(), Qt::AlignCenter, message.isEmpty() ? QString("Select a video to see its keyframes") : message);
+        return;
+    }
+
+    // Each thumbnail covers the stretch of timeline up to the next keyframe, cropped rather than squeezed
+    for (int i = 0; i < pixmaps.size(); ++i) {
+        int left = xForFrame(frames.at(i));
+        int right = i + 1 < frames.size() ? xForFrame(frames.at(i + 1)) : width();
+        if (right <= left) continue;
+        painter.save();
+        painter.setClipRect(left, 0, right - left, height());
+        painter.drawPixmap(left, 0, pixmaps.at(i));
+        painter.restore();
+    }
+
+    QColor highlight = palette().color(QPalette::Highlight);
+    if (rangeStart >= 0) {
+        int left = xForFrame(rangeStart);
+        int right = xForFrame(rangeEnd + 1);
+        painter.fillRect(0, 0, left, height(), QColor(0, 0, 0, 160));
+        painter.fillRect(right, 0, width() - right, height(), QColor(0, 0, 0, 160));
+        painter.setPen(QPen(highlight, 2));
+        painter.drawLine(left, 0, left, height());
+        painter.drawLine(right, 0, right, height());
+    }
+
+    if (hoverFrame >= 0) {
+        int x = xForFrame(hoverFrame);
+        painter.setPen(QPen(Qt::white, 1));
+        painter.drawLine(x, 0, x, height());
+
+        QString label = frameRate > 0 ? QString("%1  %2 s").arg(hoverFrame).arg(hoverFrame / frameRate, 0, 'f', 2)
+                                      : QString::number(hoverFrame);
+        QRect box = painter.fontMetrics().boundingRect(label).adjusted(-4, -2, 4, 2);
+        box.moveTopLeft(QPoint(qMin(x + 4, width() - box.width()), 2));
+        painter.fillRect(box, QColor(0, 0, 0, 200));
+        painter.drawText(box, Qt::AlignCenter, label);
+    }
+}
+
+void ThumbnailStrip::mousePressEvent(QMouseEvent *event)
+{
+    int frame = frameAt(event->position().toPoint().x());
+    if (frame < 0) return;
+    if (event->button() == Qt::RightButton) {
+        emit endFrameSelected(frame);
+    } else if (event->button() == Qt::LeftButton) {
+        anchorFrame = frame;
+        dragging = false;
+    }
+}
+
+void ThumbnailStrip::mouseMoveEvent(QMouseEvent *event)
+{
+    hoverFrame = frameAt(event->position().toPoint().x());
+    if (anchorFrame >= 0 && hoverFrame >= 0 && (event->buttons() & Qt::LeftButton)
+        && (dragging || hoverFrame != anchorFrame)) {
+        dragging = true;
+        emit rangeSelected(qMin(anchorFrame, hoverFrame), qMax(anchorFrame, hoverFrame));
+    }
+    update();
+}
+
+void ThumbnailStrip::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton || anchorFrame < 0) return;
+    if (!dragging) {
+        if (event->modifiers() & Qt::ShiftModifier) {
+            emit endFrameSelected(anchorFrame);
+        } else {
+            emit startFrameSelected(anchorFrame);
+        }
+    }
+    anchorFrame = -1;
+    dragging = false;
+}
+
+void ThumbnailStrip::leaveEvent(QEvent *event)
+{
+    Q_UNUSED(event);
+    hoverFrame = -1;
+    update();
+}
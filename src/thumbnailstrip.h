@@ -0,0 +1,54 @@
+// thumbnailstrip.h
+#ifndef THUMBNAILSTRIP_H
+#define THUMBNAILSTRIP_H
+
+#include <QWidget>
+#include <QPixmap>
+#include "thumbnailcache.h"
+
+// A row of keyframe thumbnails laid out along the video's timeline. Moving
+// the mouse scrubs a cursor that shows the frame under it; a click sets the
+// start of the range, a right or shift click its end, and dragging selects a
+// whole range at once. Frames outside the selected range are dimmed.
+class ThumbnailStrip : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ThumbnailStrip(QWidget *parent = nullptr);
+
+    void setThumbnails(const ThumbnailSet &set);
+    void clear(const QString &message = QString());
+    void setRange(int start, int end); // start -1 shows no range (whole video)
+
+    QSize sizeHint() const override;
+
+signals:
+    void startFrameSelected(int frame);
+    void endFrameSelected(int frame);
+    void rangeSelected(int start, int end);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+
+private:
+    int frameAt(int x) const;
+    int xForFrame(int frame) const;
+
+    QList<QPixmap> pixmaps;
+    QList<int> frames;
+    int frameCount;
+    double frameRate;
+    int rangeStart;
+    int rangeEnd;
+    int hoverFrame;  // -1 when the mouse is elsewhere
+    int anchorFrame; // where the left button went down, -1 when it is up
+    bool dragging;
+    QString message;
+};
+
+#endif // THUMBNAILSTRIP_H
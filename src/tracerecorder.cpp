@@ -0,0 +1,110 @@
+// tracerecorder.cpp
+#include "tracerecorder.h"
+#include <QJsonDocument>
+#include <QSaveFile>
+
+namespace {
+
+// A night of a few hundred jobs is a few thousand events; this only guards against runaway tracing
+const int MaxEvents = 1000000;
+
+} // namespace
+
+TraceRecorder::TraceRecorder()
+    : enabled(false)
+    , started(QDateTime::currentDateTimeUtc())
+{
+    clock.start();
+    trackNames.insert(InteractiveTrack, "Interactive");
+    trackNames.insert(ScannerTrack, "Scanner");
+}
+
+void TraceRecorder::setEnabled(bool on)
+{
+    enabled = on;
+}
+
+void TraceRecorder::clear()
+{
+    events = QJsonArray();
+    clock.restart();
+    started = QDateTime::currentDateTimeUtc();
+}
+
+qint64 TraceRecorder::now() const
+{
+    return clock.nsecsElapsed() / 1000;
+}
+
+void TraceRecorder::nameTrack(int track, const QString &name)
+{
+    trackNames.insert(track, name);
+}
+
+void TraceRecorder::append(const QJsonObject &event)
+{
+    if (!enabled || events.size() >= MaxEvents) return;
+    QJsonObject stamped = event;
+    stamped["pid"] = 1;
+    events.append(stamped);
+}
+
+void TraceRecorder::span(int track, const QString &name, const QString &category, qint64 startUs,
+                         const QJsonObject &args)
+{
+    if (!enabled || startUs < 0) return;
+    QJsonObject event{{"ph", "X"}, {"name", name}, {"cat", category}, {"tid", track},
+                      {"ts", startUs}, {"dur", qMax<qint64>(0, now() - startUs)}};
+    if (!args.isEmpty()) event["args"] = args;
+    append(event);
+}
+
+void TraceRecorder::instant(int track, const QString &name, const QString &category, const QJsonObject &args)
+{
+    if (!enabled) return;
+    QJsonObject event{{"ph", "i"}, {"s", "t"}, {"name", name}, {"cat", category}, {"tid", track}, {"ts", now()}};
+    if (!args.isEmpty()) event["args"] = args;
+    append(event);
+}
+
+void TraceRecorder::asyncSpan(int id, const QString &name, const QString &category, qint64 startUs,
+                              const QJsonObject &args)
+{
+    if (!enabled || startUs < 0) return;
+    // Nestable async begin/end pair; Perfetto gives each id its own row
+    QJsonObject begin{{"ph", "b"}, {"name", name}, {"cat", category}, {"id", id}, {"tid", 0}, {"ts", startUs}};
+    if (!args.isEmpty()) begin["args"] = args;
+    append(begin);
+    append({{"ph", "e"}, {"name", name}, {"cat", category}, {"id", id}, {"tid", 0}, {"ts", now()}});
+}
+
+bool TraceRecorder::exportTo(const QString &path, QString &error) const
+{
+    QJsonArray all;
+    all.append(QJsonObject{{"ph", "M"}, {"name", "process_name"}, {"pid", 1},
+                           {"args", QJsonObject{{"name", "Image Sequence Converter"}}}});
+    for (auto it = trackNames.cbegin(); it != trackNames.cend(); ++it) {
+        all.append(QJsonObject{{"ph", "M"}, {"name", "thread_name"}, {"pid", 1}, {"tid", it.key()},
+                               {"args", QJsonObject{{"name", it.value()}}}});
+        all.append(QJsonObject{{"ph", "M"}, {"name", "thread_sort_index"}, {"pid", 1}, {"tid", it.key()},
+                               {"args", QJsonObject{{"sort_index", it.key()}}}});
+    }
+    for (const QJsonValue &event : events) all.append(event);
+
+    QJsonObject root;
+    root["traceEvents"] = all;
+    root["displayTimeUnit"] = "ms";
+    root["otherData"] = QJsonObject{{"recordingStarted", started.toString(Qt::ISODateWithMs)}};
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = QString("Cannot write trace to %1").arg(path);
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        error = QString("Cannot write trace to %1").arg(path);
+        return false;
+    }
+    return true;
+}
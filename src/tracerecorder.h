@@ -0,0 +1,50 @@
+// tracerecorder.h
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QString>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QHash>
+
+// Collects timestamped spans of the job lifecycle and the conversion pipeline
+// and writes them as Chrome trace event JSON, which Perfetto and
+// chrome://tracing load directly. Each track is a "thread" in the trace:
+// one per job queue worker slot, plus the interactive converter and the
+// scanner. Waiting in the queue overlaps freely, so it is recorded as async
+// spans keyed by job id. GUI thread only.
+class TraceRecorder
+{
+public:
+    enum Track { InteractiveTrack = 0, ScannerTrack = 1, FirstSlotTrack = 10 };
+
+    TraceRecorder();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+    void clear();
+    int eventCount() const { return events.size(); }
+
+    qint64 now() const; // microseconds since the recorder started
+    void nameTrack(int track, const QString &name);
+    void span(int track, const QString &name, const QString &category, qint64 startUs,
+              const QJsonObject &args = QJsonObject());
+    void instant(int track, const QString &name, const QString &category, const QJsonObject &args = QJsonObject());
+    void asyncSpan(int id, const QString &name, const QString &category, qint64 startUs,
+                   const QJsonObject &args = QJsonObject());
+
+    bool exportTo(const QString &path, QString &error) const;
+
+private:
+    void append(const QJsonObject &event);
+
+    bool enabled;
+    QElapsedTimer clock;
+    QDateTime started;
+    QJsonArray events;
+    QHash<int, QString> trackNames;
+};
+
+#endif // TRACERECORDER_H
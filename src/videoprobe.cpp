@@ -0,0 +1,119 @@
+// videoprobe.cpp
+#include "videoprobe.h"
+#include <QProcess>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QStandardPaths>
+#include <algorithm>
+
+QString VideoProbe::ffprobePath(const QString &ffmpegPath)
+{
+    QFileInfo ffmpeg(ffmpegPath);
+    QString sibling = ffmpeg.dir().absoluteFilePath(ffmpeg.fileName().replace("ffmpeg", "ffprobe"));
+    if (QFileInfo(sibling).isExecutable()) return sibling;
+    return QStandardPaths::findExecutable("ffprobe");
+}
+
+bool VideoProbe::probe(const QString &ffmpegPath, const QString &videoPath, VideoInfo &info, QString &error)
+{
+    QString ffprobe = ffprobePath(ffmpegPath);
+    if (ffprobe.isEmpty()) {
+        error = "ffprobe not found next to ffmpeg.";
+        return false;
+    }
+
+    QProcess process;
+    process.start(ffprobe, {"-v", "error",
+                            "-show_entries", "stream=codec_type,width,height,codec_name,r_frame_rate,nb_frames,duration:format=duration",
+                            "-of", "json", videoPath});
+    if (!process.waitForFinished(30000) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        process.kill();
+        error = QString("ffprobe failed on %1: %2").arg(videoPath, QString::fromUtf8(process.readAllStandardError()).trimmed());
+        return false;
+    }
+
+    QJsonObject root = QJsonDocument::fromJson(process.readAllStandardOutput()).object();
+    // Streams come in file order; the first of each type is what -map 0:v:0 and 0:a:0 pick
+    QJsonObject stream;
+    for (const QJsonValue &value : root["streams"].toArray()) {
+        QJsonObject candidate = value.toObject();
+        QString type = candidate["codec_type"].toString();
+        if (type == "video" && stream.isEmpty()) stream = candidate;
+        if (type == "audio" && info.audioCodec.isEmpty()) info.audioCodec = candidate["codec_name"].toString();
+    }
+    if (stream.isEmpty()) {
+        error = QString("No video stream in %1").arg(videoPath);
+        return false;
+    }
+
+    info.width = stream["width"].toInt();
+    info.height = stream["height"].toInt();
+    info.codec = stream["codec_name"].toString();
+
+    // r_frame_rate is a fraction such as "24000/1001"
+    QStringList rate = stream["r_frame_rate"].toString().split('/');
+    if (rate.size() == 2 && rate.at(1).toDouble() > 0) {
+        info.frameRate = rate.at(0).toDouble() / rate.at(1).toDouble();
+    }
+
+    // ffprobe prints numbers as strings; Matroska has no per-stream duration or frame count
+    info.duration = stream["duration"].toString().toDouble();
+    if (info.duration <= 0) info.duration = root["format"].toObject()["duration"].toString().toDouble();
+    info.frameCount = stream["nb_frames"].toString().toInt();
+    if (info.frameCount <= 0 && info.frameRate > 0) {
+        info.frameCount = qRound(info.duration * info.frameRate);
+    }
+
+    if (info.width <= 0 || info.height <= 0) {
+        error = QString("Could not read the frame size of %1").arg(videoPath);
+        return false;
+    }
+    return true;
+}
+
+bool VideoProbe::keyframeTimes(const QString &ffmpegPath, const QString &videoPath, QList<double> &times, QString &error)
+{
+    QString ffprobe = ffprobePath(ffmpegPath);
+    if (ffprobe.isEmpty()) {
+        error = "ffprobe not found next to ffmpeg.";
+        return false;
+    }
+
+    // Only the container's packet index is read, so even a feature film takes seconds
+    QProcess process;
+    process.start(ffprobe, {"-v", "error", "-select_streams", "v:0",
+                            "-show_entries", "packet=pts_time,flags", "-of", "csv=p=0", videoPath});
+    if (!process.waitForFinished(120000) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        process.kill();
+        error = QString("ffprobe failed on %1: %2").arg(videoPath, QString::fromUtf8(process.readAllStandardError()).trimmed());
+        return false;
+    }
+
+    // Lines are "pts_time,flags", e.g. "41.708333,K__"
+    times.clear();
+    const QList<QByteArray> lines = process.readAllStandardOutput().split('\n');
+    for (const QByteArray &line : lines) {
+        int comma = line.indexOf(',');
+        if (comma < 0 || !line.mid(comma + 1).startsWith('K')) continue;
+        bool ok = false;
+        double time = line.left(comma).toDouble(&ok);
+        if (ok) times.append(time);
+    }
+    std::sort(times.begin(), times.end()); // packets come in decode order
+    if (times.isEmpty()) {
+        error = QString("No keyframes found in %1").arg(videoPath);
+        return false;
+    }
+    return true;
+}
+
+ProbeResult VideoProbe::probeAll(const QString &ffmpegPath, const QString &videoPath, bool withKeyframes)
+{
+    ProbeResult result;
+    result.ok = probe(ffmpegPath, videoPath, result.info, result.error)
+                && (!withKeyframes || keyframeTimes(ffmpegPath, videoPath, result.keyframes, result.error));
+    return result;
+}
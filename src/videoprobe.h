@@ -0,0 +1,38 @@
+// videoprobe.h
+#ifndef VIDEOPROBE_H
+#define VIDEOPROBE_H
+
+#include <QString>
+#include <QList>
+
+struct VideoInfo {
+    int width = 0;
+    int height = 0;
+    double frameRate = 0.0;
+    int frameCount = 0; // from the container, or estimated from duration x rate
+    double duration = 0.0;
+    QString codec;
+    QString audioCodec; // first audio stream, empty if there is none
+};
+
+struct ProbeResult {
+    bool ok = false;
+    VideoInfo info;
+    QList<double> keyframes; // only when asked for
+    QString error;
+};
+
+// Reads stream properties of a video with ffprobe, which is looked up next
+// to the ffmpeg binary in use.
+class VideoProbe
+{
+public:
+    static QString ffprobePath(const QString &ffmpegPath);
+    static bool probe(const QString &ffmpegPath, const QString &videoPath, VideoInfo &info, QString &error);
+    // Presentation times of the video's keyframes, read from packet flags without decoding
+    static bool keyframeTimes(const QString &ffmpegPath, const QString &videoPath, QList<double> &times, QString &error);
+    // Both of the above in one call, for running on a worker thread
+    static ProbeResult probeAll(const QString &ffmpegPath, const QString &videoPath, bool withKeyframes);
+};
+
+#endif // VIDEOPROBE_H
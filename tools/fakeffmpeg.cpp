@@ -0,0 +1,111 @@
+// fakeffmpeg.cpp
+// Stand-in for ffmpeg used to measure Converter's own overhead without real media.
+// Behaviour is controlled through environment variables, since Converter owns the
+// command line:
+//   FAKE_FFMPEG_FRAMES   frames to "encode" (default 100)
+//   FAKE_FFMPEG_FPS      simulated encode speed in frames per second (default 1000)
+//   FAKE_FFMPEG_RATE     stderr/-progress updates per second (default 10)
+//   FAKE_FFMPEG_BURN     1 = busy-loop instead of sleeping between updates
+//   FAKE_FFMPEG_EXIT     exit code to return (default 0)
+//   FAKE_FFMPEG_CRASH    1 = abort() halfway through
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+
+long envLong(const char *name, long fallback)
+{
+    const char *value = std::getenv(name);
+    return value && *value ? std::strtol(value, nullptr, 10) : fallback;
+}
+
+void waitFor(std::chrono::microseconds duration, bool burn)
+{
+    if (!burn) {
+        std::this_thread::sleep_for(duration);
+        return;
+    }
+    auto until = std::chrono::steady_clock::now() + duration;
+    volatile unsigned long sink = 0;
+    while (std::chrono::steady_clock::now() < until) {
+        for (int i = 0; i < 1000; ++i) sink += i;
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const long frames = envLong("FAKE_FFMPEG_FRAMES", 100);
+    const long fps = envLong("FAKE_FFMPEG_FPS", 1000);
+    const long rate = envLong("FAKE_FFMPEG_RATE", 10);
+    const bool burn = envLong("FAKE_FFMPEG_BURN", 0) != 0;
+    const int exitCode = static_cast<int>(envLong("FAKE_FFMPEG_EXIT", 0));
+    const bool crash = envLong("FAKE_FFMPEG_CRASH", 0) != 0;
+
+    std::FILE *progress = nullptr;
+    bool stdinInput = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-progress") == 0 && i + 1 < argc) {
+            progress = std::strcmp(argv[i + 1], "pipe:1") == 0 ? stdout : std::fopen(argv[i + 1], "w");
+        }
+        if (std::strcmp(argv[i], "-i") == 0 && i + 1 < argc && std::strcmp(argv[i + 1], "-") == 0) {
+            stdinInput = true;
+        }
+    }
+
+    std::fprintf(stderr,
+                 "ffmpeg version n0.0-fake Copyright (c) 2000-2024 the FFmpeg developers\n"
+                 "Input #0, image2, from 'fake_%%04d.png':\n"
+                 "  Duration: 00:00:04.00, start: 0.000000, bitrate: N/A\n"
+                 "  Stream #0:0: Video: png, rgb24(pc), 1920x1080, 24 fps, 24 tbr, 24 tbn\n"
+                 "Output #0, mp4, to 'fake.mp4':\n"
+                 "  Stream #0:0: Video: h264 (avc1 / 0x31637661), yuv420p(tv, progressive), 1920x1080, q=2-31, 24 fps\n"
+                 "Press [q] to stop, [?] for help\n");
+
+    // Drain piped frames the way ffmpeg would, so follow-mode writers don't block
+    if (stdinInput) {
+        char buffer[65536];
+        while (std::fread(buffer, 1, sizeof(buffer), stdin) > 0) {}
+    }
+
+    const long updates = rate > 0 && fps > 0 ? std::max(1L, frames * rate / fps) : 1;
+    const auto interval = std::chrono::microseconds(fps > 0 ? frames * 1000000L / fps / updates : 0);
+    const auto start = std::chrono::steady_clock::now();
+
+    for (long update = 1; update <= updates; ++update) {
+        waitFor(interval, burn);
+
+        if (crash && update * 2 >= updates) {
+            std::fflush(stderr);
+            std::abort();
+        }
+
+        long frame = frames * update / updates;
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double speed = elapsed > 0 ? (frame / 24.0) / elapsed : 0.0;
+        long outTimeUs = frame * 1000000L / 24;
+        std::fprintf(stderr, "frame=%5ld fps=%.1f q=28.0 size=%8ldkB time=%02ld:%02ld:%02ld.%02ld bitrate=N/A speed=%.2fx\r",
+                     frame, elapsed > 0 ? frame / elapsed : 0.0, frame * 12,
+                     outTimeUs / 3600000000L, (outTimeUs / 60000000L) % 60, (outTimeUs / 1000000L) % 60,
+                     (outTimeUs / 10000L) % 100, speed);
+        std::fflush(stderr);
+
+        if (progress) {
+            std::fprintf(progress, "frame=%ld\nfps=%.1f\nout_time_us=%ld\nspeed=%.2fx\nprogress=%s\n",
+                         frame, elapsed > 0 ? frame / elapsed : 0.0, outTimeUs, speed,
+                         update == updates ? "end" : "continue");
+            std::fflush(progress);
+        }
+    }
+
+    std::fprintf(stderr, "\nvideo:%ldkB audio:0kB subtitle:0kB other streams:0kB global headers:0kB muxing overhead: 0.1%%\n",
+                 frames * 12);
+    if (progress && progress != stdout) std::fclose(progress);
+    return exitCode;
+}
@@ -0,0 +1,234 @@
+// stresstest.cpp
+// Runs thousands of short jobs through Converter against fakeffmpeg and reports
+// scheduling latency, per-job overhead and memory growth. --check-arguments
+// instead verifies the ffmpeg input arguments of incremental segments.
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProgressBar>
+#include <QTemporaryDir>
+#include <QTextEdit>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include "converter.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Resident set size in KiB
+qint64 residentKiB()
+{
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly)) {
+        for (const QByteArray &line : status.readAll().split('\n')) {
+            if (line.startsWith("VmRSS:")) {
+                return line.mid(6).trimmed().split(' ').first().toLongLong();
+            }
+        }
+    }
+#ifdef Q_OS_UNIX
+    // Peak RSS is the best portable approximation (bytes on macOS, KiB on Linux)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef Q_OS_MACOS
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+double percentile(QList<double> values, double p)
+{
+    if (values.isEmpty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    int index = qBound(0, static_cast<int>(p * (values.size() - 1) + 0.5), static_cast<int>(values.size()) - 1);
+    return values.at(index);
+}
+
+void report(const char *name, const QList<double> &values)
+{
+    std::printf("%-22s p50 %8.2f ms   p95 %8.2f ms   p99 %8.2f ms   max %8.2f ms\n", name,
+                percentile(values, 0.50), percentile(values, 0.95),
+                percentile(values, 0.99), percentile(values, 1.0));
+}
+
+// Segment 2 of an incremental encode of frames without numbers must seek past segment 1,
+// since the glob input has no start number to do it
+int checkArguments()
+{
+    QStringList files;
+    for (const char *name : {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel"}) {
+        files << QString("/shots/plate/%1.png").arg(name);
+    }
+    Converter converter(nullptr, false);
+    const QStringList args = converter.buildSequenceInputArguments(files, 4, 4, 24);
+    int seek = args.indexOf("-ss");
+    int input = args.indexOf("-i");
+    int frames = args.indexOf("-frames:v");
+    bool ok = seek >= 0 && input > seek && args.value(seek + 1) == "0.166667"
+              && frames > input && args.value(frames + 1) == "4";
+    std::printf("segment 2 of an unnumbered sequence: %s\n  %s\n", ok ? "ok" : "FAILED", qPrintable(args.join(" ")));
+    return ok ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // The widget sink needs a QApplication; everything else runs headless
+    bool withWidgets = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--widgets") == 0) withWidgets = true;
+    }
+    std::unique_ptr<QCoreApplication> app(withWidgets ? new QApplication(argc, argv)
+                                                      : new QCoreApplication(argc, argv));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Converter scheduling stress test");
+    parser.addHelpOption();
+    parser.addOption({"jobs", "Number of jobs to run.", "count", "2000"});
+    parser.addOption({"frames", "Frames each fake job reports.", "count", "48"});
+    parser.addOption({"fps", "Simulated encode speed of the fake ffmpeg.", "fps", "4800"});
+    parser.addOption({"rate", "Progress updates per second from the fake ffmpeg.", "hz", "100"});
+    parser.addOption({"fail-every", "Make every Nth job exit with code 1.", "n", "0"});
+    parser.addOption({"crash-every", "Make every Nth job crash.", "n", "0"});
+    parser.addOption({"burn", "Busy-loop instead of sleeping in the fake ffmpeg."});
+    parser.addOption({"widgets", "Deliver log and progress to a QTextEdit/QProgressBar like MainWindow."});
+    parser.addOption({"fake", "Path to the fakeffmpeg executable.", "path",
+                      QCoreApplication::applicationDirPath() + "/fakeffmpeg"});
+    parser.addOption({"check-arguments", "Only check the input arguments built for incremental segments."});
+    parser.process(*app);
+    if (parser.isSet("check-arguments")) return checkArguments();
+
+    const int jobs = parser.value("jobs").toInt();
+    const int frames = parser.value("frames").toInt();
+    const int fps = parser.value("fps").toInt();
+    const int failEvery = parser.value("fail-every").toInt();
+    const int crashEvery = parser.value("crash-every").toInt();
+    const double expectedMs = fps > 0 ? frames * 1000.0 / fps : 0.0;
+
+    if (!QFile::exists(parser.value("fake"))) {
+        std::fprintf(stderr, "fakeffmpeg not found at %s\n", qPrintable(parser.value("fake")));
+        return 1;
+    }
+
+    // Converter only lists the input directory, so empty frames are enough
+    QTemporaryDir workDir;
+    for (int i = 1; i <= 3; ++i) {
+        QFile frame(workDir.filePath(QString("frame_%1.png").arg(i, 4, 10, QChar('0'))));
+        if (!frame.open(QIODevice::WriteOnly)) {
+            std::fprintf(stderr, "cannot create %s\n", qPrintable(frame.fileName()));
+            return 1;
+        }
+    }
+
+    qputenv("FAKE_FFMPEG_FRAMES", QByteArray::number(frames));
+    qputenv("FAKE_FFMPEG_FPS", QByteArray::number(fps));
+    qputenv("FAKE_FFMPEG_RATE", parser.value("rate").toLatin1());
+    qputenv("FAKE_FFMPEG_BURN", parser.isSet("burn") ? "1" : "0");
+
+    Converter converter;
+    converter.setFFmpegPath(parser.value("fake"));
+
+    QTextEdit *logSink = nullptr;
+    QProgressBar *progressSink = nullptr;
+    if (withWidgets) {
+        logSink = new QTextEdit();
+        progressSink = new QProgressBar();
+        QObject::connect(&converter, &Converter::logMessage, logSink, &QTextEdit::append);
+        QObject::connect(&converter, &Converter::progressChanged, progressSink, &QProgressBar::setValue);
+    }
+
+    ConversionSettings settings;
+    settings.inputPath = workDir.path();
+    settings.outputPath = workDir.filePath("out.mp4");
+    settings.videoFormat = "mp4";
+    settings.videoCodec = "H.264";
+    settings.frameRate = 24;
+    settings.quality = 23;
+    settings.width = 1920;
+    settings.height = 1080;
+    settings.maintainAspectRatio = true;
+    settings.extractAllFrames = true;
+    settings.startFrame = 0;
+    settings.endFrame = 0;
+
+    QList<double> latencies;
+    QList<double> overheads;
+    QList<double> gaps;
+    int succeeded = 0;
+    int failed = 0;
+    int signalsDelivered = 0;
+    int jobIndex = 0;
+    bool firstSignal = false;
+    QElapsedTimer jobTimer;
+    QElapsedTimer gapTimer;
+    QElapsedTimer totalTimer;
+    const qint64 rssBefore = residentKiB();
+    qint64 rssAfterWarmup = 0;
+
+    std::function<void()> startJob = [&]() {
+        if (jobIndex >= jobs) {
+            app->quit();
+            return;
+        }
+        ++jobIndex;
+        qputenv("FAKE_FFMPEG_EXIT", failEvery > 0 && jobIndex % failEvery == 0 ? "1" : "0");
+        qputenv("FAKE_FFMPEG_CRASH", crashEvery > 0 && jobIndex % crashEvery == 0 ? "1" : "0");
+        if (gapTimer.isValid()) gaps.append(gapTimer.nsecsElapsed() / 1e6);
+        firstSignal = false;
+        jobTimer.start();
+        converter.convertSequenceToVideo(settings);
+    };
+
+    auto onSignal = [&]() {
+        ++signalsDelivered;
+        if (!firstSignal) {
+            firstSignal = true;
+            latencies.append(jobTimer.nsecsElapsed() / 1e6);
+        }
+    };
+    QObject::connect(&converter, &Converter::progressChanged, onSignal);
+    QObject::connect(&converter, &Converter::logMessage, [&](const QString &message) {
+        // The command echo is emitted before spawning; only count output from the child
+        if (!message.startsWith("Command:") && !message.startsWith("Starting")) onSignal();
+    });
+    QObject::connect(&converter, &Converter::finished, [&](bool success, const QString &) {
+        overheads.append(jobTimer.nsecsElapsed() / 1e6 - expectedMs);
+        if (success) ++succeeded; else ++failed;
+        if (jobIndex == qMin(jobs, 100)) rssAfterWarmup = residentKiB();
+        gapTimer.start();
+        // Queue the next job like MainWindow would, after the finished handlers return
+        QTimer::singleShot(0, startJob);
+    });
+
+    totalTimer.start();
+    QTimer::singleShot(0, startJob);
+    app->exec();
+    const double totalMs = totalTimer.nsecsElapsed() / 1e6;
+    const qint64 rssAfter = residentKiB();
+
+    std::printf("jobs %d (ok %d, failed %d), %d frames at %d fps each, %.1f ms expected per job\n",
+                jobs, succeeded, failed, frames, fps, expectedMs);
+    std::printf("wall %.1f s, %.1f jobs/s, %d signals delivered\n",
+                totalMs / 1000.0, jobs / (totalMs / 1000.0), signalsDelivered);
+    report("first output latency", latencies);
+    report("per-job overhead", overheads);
+    report("finish-to-next gap", gaps);
+    std::printf("rss start %lld KiB, after warmup %lld KiB, end %lld KiB, growth after warmup %lld KiB\n",
+                rssBefore, rssAfterWarmup, rssAfter, rssAfter - rssAfterWarmup);
+
+    delete logSink;
+    delete progressSink;
+    return failed > 0 && failEvery == 0 && crashEvery == 0 ? 1 : 0;
+}